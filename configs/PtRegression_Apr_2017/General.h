@@ -7,6 +7,8 @@ const int MAX_EVT    =  4000000;  // Number of MC events to process          (4M
 const int MAX_TR     =  2000000;  // Number of MC events to use for training (2M default for mode 15)
 const int REPORT_EVT =    10000;  // Report every Nth event during processing
 const int MAX_ZB_FIL =       50;  // Number of ZeroBias files to include (~200 CSC-only, ~30 with RPC)
+const int N_STAGE    =        2;  // Number of input files copied to STAGE_DIR ahead of the one being read
+const int NTHREADS_IO =       8;  // Threads opening the input files at startup (only for files not in MANIFEST_FILE)
 
 /* // // ***** Test settings ***** // // */
 /* const int MAX_EVT    =  40000;  // Number of MC events to process */
@@ -34,6 +36,31 @@ const std::vector<int> EMTF_MODES = {15, 14, 13, 12, 11, 10, 9, 7, 6, 5, 3};  //
 
 // *** Output data options *** //
 const bool SPEC_VARS = true;  // When generating final XMLs, set to "false" to leave out spectators
+const bool PAR_TEST  = true;  // Score the test sample with ParallelScorer instead of TestAllMethods()
+const int NTHREADS_TEST = 8;  // Threads scoring the test sample, if PAR_TEST
+const int K_FOLD      = 0;    // Folds for cross-validation of the methods instead of the even / odd training (0 or 1: off)
+const int NPROC_KFOLD = 5;    // Folds trained at the same time, in separate processes, if K_FOLD > 1
+
+// *** Output trees (TrainTree / TestTree) *** //
+const bool OUT_ASYNC       = true;     // Compress the trees on a background thread while the next factory trains
+const int  OUT_COMP_ALG    = 1;        // ROOT compression algorithm: 1 ZLIB, 2 LZMA, 4 LZ4 (fastest to read), 5 ZSTD (ROOT >= 6.20)
+const int  OUT_COMP_LEVEL  = 1;        // Compression level, 0 - 9
+const int  OUT_BASKET_SIZE = 32000;    // Bytes per branch basket: larger baskets compress and read faster, with more memory
+const std::vector<TString> OUT_DROP_BRANCHES = {};  // Branches not written (wildcards as in SetBranchStatus), e.g. "className"
+
+// *** Checkpoints (CKPT_FILE in User.h, or --shard) *** //
+const int CKPT_EVT = 100000;  // Input events between checkpoints of the feature file (0: none)
+
+// *** Input variable search *** //
+const bool   VAR_SEARCH  = false;       // Rank in_vars masks with fast proxy BDTs instead of training with TMVA
+const UInt_t VS_POOL     = 0xffdfffff;  // Variables the search may add or remove (all but "filler")
+const int    VS_BEAM     = 1;           // Masks kept at each step (1 = greedy)
+const int    VS_STEPS    = 10;          // Maximum number of variables added or removed
+const bool   VS_FORWARD  = true;        // Try adding each variable of the pool
+const bool   VS_BACKWARD = true;        // Try removing each variable of the mask
+const int    VS_PRESCALE = 4;           // Use every Nth MC event in the search
+const int    VS_MAX_TRK  = 200000;      // Maximum number of tracks used in the search
+const int    NTHREADS_VS = 8;           // Threads training candidate masks
 
 // *** High-pT muons *** //
 const double PTMIN_TR =    1.;  // Minimum GEN pT for training
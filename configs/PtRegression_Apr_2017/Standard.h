@@ -10,6 +10,6 @@ const double ETAMIN =     1.0; // Minimum GEN |eta|
 const double ETAMAX =     2.5; // Maximum GEN |eta|
 
 // *** Track-building settings *** //
-const int  MAX_DPH  = 1024;  // Maximum dPhi between hits for track-building (excludes maximum)
-const int  MAX_DTH  = 8;     // Maximum dTheta between hits for track-building (includes maximum)
+const int  MAX_DPH  = TRK_MAX_DPH;  // Maximum dPhi between hits for track-building (excludes maximum)
+const int  MAX_DTH  = TRK_MAX_DTH;  // Maximum dTheta between hits for track-building (includes maximum)
 
@@ -3,6 +3,10 @@
 TString OUT_DIR_NAME  = ".";  // Directory for output ROOT file
 TString OUT_FILE_NAME = "PtRegression_Apr_2017";  // Name base for output ROOT file
 TString EOS_DIR_NAME  = "root://eoscms.cern.ch//store/user/abrinke1/EMTF/Emulator/ntuples";  // Input directory in eos
+TString STAGE_DIR     = "";   // Local scratch directory for staging input files (empty to read them in place)
+TString MANIFEST_FILE = "PtRegression_Apr_2017_manifest.txt";  // Cached entries of the input files (empty to disable)
+TString SKIM_FILE     = "";   // Mode-indexed skim from macros/SkimNTuples.C (empty to read every event)
+TString CKPT_FILE     = "";   // Features of the event loop, checkpointed to <CKPT_FILE>.ckpt for a resume (empty to disable)
 
 namespace PtRegression_Apr_2017_cfg {
   
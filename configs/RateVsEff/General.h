@@ -19,3 +19,7 @@ const int    PTBINS  =   50;  // Number of bins in rate plot
 const int    PTDIVS  =   10;  // Number of trigger pT bins per GEN pT bin, before scaling
 const double ERRMIN  = 0.02;  // Minimum per-bin uncertainty allowed in efficiency plots
 const double BIT     = 0.1 * (PTMAX - PTMIN) / (PTBINS * PTDIVS);  // Small pT offset increment
+
+// *** Bootstrap uncertainties *** //
+const int       N_BOOT    =     0;  // Poisson bootstrap replicas filled in the same event loop (0 to disable)
+const ULong64_t BOOT_SEED = 12345;  // Seed of the replica weights
@@ -126,6 +126,22 @@ namespace RateVsEff_cfg {
       BDT_invPt_Sq_RPC.modes_RPC    = {1, 2, 4, 8};
       BDT_invPt_Sq_RPC.color        = 2;  // kRed
 
+      // Same BDT evaluated in fixed point from its weight file, as it will be stored in the LUT
+      PtAlgo BDT_invPt_Sq_LUT = BDT_invPt_Sq;
+      TString wgt_str;
+      wgt_str.Form("%s/weights/%s_BDTG_AWB_Sq.weights.xml", fact_str.Data(), fact_str.Data());
+      BDT_invPt_Sq_LUT.BDT_file_name = IN_DIR_NAME+"/"+wgt_str;
+      BDT_invPt_Sq_LUT.unique_ID     = BDT_invPt_Sq.unique_ID+"_LUT";  // ID_str carries the _match suffix by now
+      BDT_invPt_Sq_LUT.alias         = "invPt target, LeastSq loss, CSC-only, fixed-point";
+      BDT_invPt_Sq_LUT.color         = 6;  // kMagenta
+
+      // Same, looked up in a generated LUT at the compressed track address
+      PtAlgo BDT_invPt_Sq_LUT_file = BDT_invPt_Sq_LUT;
+      BDT_invPt_Sq_LUT_file.LUT_file_name = IN_DIR_NAME+"/LUTs/"+fact_str+"_BDTG_AWB_Sq.lut";
+      BDT_invPt_Sq_LUT_file.unique_ID     = BDT_invPt_Sq_LUT.unique_ID+"_file";
+      BDT_invPt_Sq_LUT_file.alias         = "invPt target, LeastSq loss, CSC-only, LUT lookup";
+      BDT_invPt_Sq_LUT_file.color         = 28; // kBrown
+
 
       ALGOS.push_back(EMTF15);  // First algo is always the standard comparison algo
       ALGOS.push_back(EMTF);
@@ -138,6 +154,8 @@ namespace RateVsEff_cfg {
       ALGOS.push_back(BDT_invPt_Sq);
       ALGOS.push_back(BDT_invPt_Sq_match);
       ALGOS.push_back(BDT_invPt_Sq_RPC);
+      // ALGOS.push_back(BDT_invPt_Sq_LUT);
+      // ALGOS.push_back(BDT_invPt_Sq_LUT_file);
 
     } // End conditional: if (USER == "AWB")
 
@@ -27,6 +27,12 @@ const std::vector<int> EMTF_MODES = {15, 14, 13, 12, 11, 10, 9, 7, 6, 5, 3};  //
 // *** Output data options *** //
 const bool SPEC_VARS = true;  // When generating final XMLs, set to "false" to leave out spectators
 
+// *** Classes *** //
+// GEN pT boundaries of each class scheme, in decreasing order: class1 is above the first, the last class below the last
+const std::vector< std::vector<double> > CLASS_SCHEMES = { {32, 24, 16, 8} };
+const int  SCHEME        = 0;      // Index of the scheme to train in CLASS_SCHEMES
+const bool WRITE_DATASET = false;  // Write the tracks with the labels of every scheme, instead of training
+
 // *** High-pT muons *** //
 const double PTMIN_TR =    1.;  // Minimum GEN pT for training
 const double PTMAX_TR =  256.;  // Maximum GEN pT for training
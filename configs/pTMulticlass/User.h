@@ -3,6 +3,8 @@
 TString OUT_DIR_NAME  = ".";  // Directory for output ROOT file
 TString OUT_FILE_NAME = "pTMulticlass";  // Name base for output ROOT file
 TString EOS_DIR_NAME  = "root://eoscms.cern.ch//store/user/abrinke1/EMTF/Emulator/ntuples";  // Input directory in eos
+TString MANIFEST_FILE = "pTMulticlass_manifest.txt";  // Cached entries of the input files (empty to disable)
+TString DATASET_FILE  = "";  // Output of a WRITE_DATASET run: if set, train from it instead of the ntuples
 
 namespace pTMulticlass_cfg {
   
@@ -0,0 +1,66 @@
+#ifndef EMTFPtAssign2017_Bootstrap_h
+#define EMTFPtAssign2017_Bootstrap_h
+
+#include <vector>
+
+#include "Rtypes.h"
+
+// Single-pass Poisson bootstrap: every event enters each of K replicas with an integer weight
+// drawn from Poisson(1).  The weights are a hash of (seed, event ID, replica) only, so they need
+// no extra pass or I/O, are reproducible, and are the same for every algorithm reading the same
+// events.  Replica counts are kept in flat integer arrays rather than K ROOT histograms.
+
+class PoissonBootstrap {
+
+ public:
+
+  // Default constructor
+  PoissonBootstrap( const int _n_rep = 0, const ULong64_t _seed = 12345 ) {
+    n_rep = _n_rep;
+    seed  = _seed;
+  } // End default constructor PoissonBootstrap()
+
+  // Weights of one event in each of the n_rep replicas
+  void Weights( const ULong64_t event_id, std::vector<UChar_t>& weights ) const;
+
+  int       n_rep;
+  ULong64_t seed;
+
+}; // End class PoissonBootstrap
+
+
+// n_rep replicas of a 2D histogram with fixed binning, numbered as in TH2 (0 underflow, n + 1 overflow)
+class BootHist2D {
+
+ public:
+
+  BootHist2D( const int _n_rep, const int _nx, const double _xmin, const double _xmax,
+	      const int _ny, const double _ymin, const double _ymax );
+
+  void Fill( const double x, const double y, const std::vector<UChar_t>& weights );
+
+  // Call once after filling: each bin then holds the sum of the bins from it up to ny in y,
+  // so that Integral() only sums over x bins
+  void Cumulate();
+
+  // Sum of replica iRep over x bins [ix1, ix2] and y bins [iy1, ny], as TH2::Integral(ix1, ix2, iy1, ny)
+  double Integral( const int iRep, int ix1, int ix2, int iy1 ) const;
+
+  int n_rep;
+  int nx, ny;
+  double xmin, xmax, ymin, ymax;
+
+ private:
+
+  int Bin( const double v, const int n, const double vmin, const double vmax ) const;
+
+  std::vector<UInt_t> counts;  // n_rep x (nx + 2) x (ny + 2)
+  bool cumulated;
+
+}; // End class BootHist2D
+
+
+// Central 68% interval of the replica values, and their standard deviation
+void BootBand( std::vector<double> vals, double& lo, double& hi, double& rms );
+
+#endif
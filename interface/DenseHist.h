@@ -0,0 +1,74 @@
+#ifndef EMTFPtAssign2017_DenseHist_h
+#define EMTFPtAssign2017_DenseHist_h
+
+#include <vector>
+
+#include "Rtypes.h"
+
+class TH1;
+
+// Store of n_hist histograms with the same fixed binning, in one contiguous array, for the macros
+// which fill large matrices of histograms (MVA x pT x eta x train / test) in the event loop.
+// Filling is plain index arithmetic: no virtual calls, no TDirectory registration, no per-object
+// overhead.  Bins are numbered as in ROOT (0 underflow, n + 1 overflow, global bin ix + (nx + 2) * iy),
+// so a histogram is copied into a TH1D / TH2D of the same binning only when it is needed for output.
+// Stores filled by different threads are merged with Add().
+
+class DenseHist {
+
+ public:
+
+  // 1D histograms if ny = 0
+  DenseHist( const int _n_hist, const int _nx, const double _xmin, const double _xmax,
+	     const int _ny = 0, const double _ymin = 0, const double _ymax = 1 );
+
+  int Index( const int iHist ) const { return iHist * n_cells; }
+
+  void Fill( const int iHist, const double x, const double w = 1.0 ) {
+    const int bin = Index(iHist) + XBin(x);
+    sumw [bin] += w;
+    sumw2[bin] += w*w;
+    entries[iHist] += 1;
+  }
+  void Fill( const int iHist, const double x, const double y, const double w ) {
+    const int bin = Index(iHist) + XBin(x) + (nx + 2) * YBin(y);
+    sumw [bin] += w;
+    sumw2[bin] += w*w;
+    entries[iHist] += 1;
+  }
+
+  double Content( const int iHist, const int ix, const int iy = 0 ) const { return sumw.at( Index(iHist) + ix + (nx + 2) * iy ); }
+  double Integral( const int iHist ) const;  // In-range bins only, as TH1::Integral()
+
+  // Add the contents of a store with the same layout
+  void Add( const DenseHist& other );
+  void Reset();
+
+  // Copy histogram iHist into hist, which must have the same binning; returns false if it does not
+  bool CopyTo( const int iHist, TH1* hist ) const;
+
+  int    n_hist;
+  int    nx, ny;
+  double xmin, xmax, ymin, ymax;
+  int    n_cells;  // (nx + 2) * (ny + 2), or nx + 2 in 1D
+
+ private:
+
+  int XBin( const double x ) const {
+    if ( x < xmin )    return 0;
+    if ( !(x < xmax) ) return nx + 1;  // NaN to overflow, as in ROOT
+    return 1 + int( nx * (x - xmin) / (xmax - xmin) );  // As TAxis::FindFixBin()
+  }
+  int YBin( const double y ) const {
+    if ( y < ymin )    return 0;
+    if ( !(y < ymax) ) return ny + 1;
+    return 1 + int( ny * (y - ymin) / (ymax - ymin) );
+  }
+
+  std::vector<double>   sumw;
+  std::vector<double>   sumw2;
+  std::vector<Long64_t> entries;
+
+}; // End class DenseHist
+
+#endif
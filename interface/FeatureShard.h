@@ -0,0 +1,166 @@
+#ifndef EMTFPtAssign2017_FeatureShard_h
+#define EMTFPtAssign2017_FeatureShard_h
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <string>
+
+#include "TString.h"
+
+// Track features written by one shard of PtRegression_Apr_2017 (shard i of N reads the i-th cluster-aligned
+// range of the input entries), instead of being loaded into the TMVA factories.  Each row holds what the
+// loading step of the driver needs: the MC event ordinal (iEvt), isMC, trainEvt, the factory index, the
+// event weight and the variable values.  The train / test split (iEvt % 2 and MAX_TR) is not applied by the
+// shards, since nTrain depends on all earlier events: MergeFeatureShards() concatenates the shards in
+// global order with global ordinals, and the driver replays the merged file through the same loading step.
+// File: FeatureShardHeader, then for each factory its name (uint32 length, characters) and uint32 number
+// of values, then the rows: uint32 iEvt, uint8 isMC, uint8 trainEvt, uint16 factory, then n + 1 doubles
+// (weight, values).  All fields are native-endian: shards are merged on the same kind of machine that wrote them.
+
+const char     FEATURE_SHARD_MAGIC[8] = {'E', 'M', 'T', 'F', 'F', 'E', 'A', 'T'};
+const uint32_t FEATURE_SHARD_VERSION  = 1;
+
+struct FeatureShardHeader {
+
+  char     magic[8];         // FEATURE_SHARD_MAGIC
+  uint32_t version;          // FEATURE_SHARD_VERSION
+  uint32_t shard_index;      // Shard i of shard_count; 0 of 1 for a merged file
+  uint32_t shard_count;
+  uint32_t global_ordinals;  // iEvt of the rows is global (skim ordinals, or merged); else counted from the start of the shard
+  uint64_t n_MC;             // MC events read by the shard (its iEvt at the end)
+  uint64_t n_ZB;             // ZeroBias events read by the shard
+  uint64_t n_rows;
+  uint32_t n_fact;
+  uint32_t reserved;
+
+}; // End struct FeatureShardHeader
+
+
+// One row: the arguments of one AddTrainingEvent() / AddTestEvent() call, before the split
+struct FeatureRow {
+  uint32_t iEvt;
+  bool     isMC;
+  bool     trainEvt;
+  int      iFact;
+  double   weight;
+  std::vector<double> vals;
+}; // End struct FeatureRow
+
+
+class FeatureShardWriter {
+
+ public:
+
+  // Default constructor
+  FeatureShardWriter() {
+    file = 0;
+  } // End default constructor FeatureShardWriter()
+
+  ~FeatureShardWriter() { if (file) fclose(file); }
+
+  // Written as <name>.tmp and renamed by Close(), so the merge never reads a shard which did not finish
+  bool Open( const TString _file_name, const int shard_index, const int shard_count, const bool global_ordinals,
+	     const std::vector<TString>& fact_names, const std::vector<int>& n_vals );
+  void AddRow( const uint32_t iEvt, const bool isMC, const bool trainEvt, const int iFact,
+	       const std::vector<Double_t>& vals, const double weight );
+  bool Close( const uint64_t n_MC, const uint64_t n_ZB );
+
+  // Checkpoint: the rows added so far are on disk, in the first bytes of <name>.tmp
+  bool Flush( uint64_t& bytes );
+
+  // Continue the <name>.tmp of an interrupted run from a checkpoint: keep its first n_rows rows (bytes),
+  // and append after them.  False if the file is shorter, or was opened with other arguments.
+  bool Resume( const TString _file_name, const int shard_index, const int shard_count, const bool global_ordinals,
+	       const std::vector<TString>& fact_names, const std::vector<int>& _n_vals,
+	       const uint64_t n_rows, const uint64_t bytes );
+
+  TString file_name;
+  FeatureShardHeader header;
+
+ private:
+
+  FeatureShardWriter( const FeatureShardWriter& );
+  FeatureShardWriter& operator=( const FeatureShardWriter& );
+
+  FILE* file;
+  std::vector<int> n_vals;
+  std::vector<double> buf;
+
+}; // End class FeatureShardWriter
+
+
+class FeatureShardReader {
+
+ public:
+
+  // Default constructor
+  FeatureShardReader() {
+    file   = 0;
+    n_read = 0;
+  } // End default constructor FeatureShardReader()
+
+  ~FeatureShardReader() { Close(); }
+
+  bool Open( const TString _file_name );
+  void Close();
+
+  // Next row, false at the end of the file; n_read < header.n_rows then if the file was truncated
+  bool Next( FeatureRow& row );
+  bool Complete() const { return (n_read == header.n_rows); }
+
+  // Same factories and numbers of values, e.g. as the configuration of the driver
+  bool SameFactories( const std::vector<TString>& _fact_names, const std::vector<int>& _n_vals ) const;
+
+  TString file_name;
+  FeatureShardHeader header;
+  std::vector<TString> fact_names;
+  std::vector<int> n_vals;
+  uint64_t n_read;
+
+ private:
+
+  FeatureShardReader( const FeatureShardReader& );
+  FeatureShardReader& operator=( const FeatureShardReader& );
+
+  FILE* file;
+
+}; // End class FeatureShardReader
+
+
+// Position of an event loop writing features (FeatureShardWriter), to resume it after an interruption:
+// the next global input entry, the event counters, and the rows and bytes of <feature file>.tmp up to
+// that entry.  Written atomically (text, then rename), and removed once the feature file is complete.
+struct FeatureCheckpoint {
+
+  // Default constructor
+  FeatureCheckpoint() {
+    config = 0;
+    entry  = 0;
+    iEvt   = 0;
+    iEvtZB = 0;
+    n_rows = 0;
+    bytes  = 0;
+  } // End default constructor FeatureCheckpoint()
+
+  bool Write( const TString file_name ) const;
+  bool Read( const TString file_name );  // False if there is no valid checkpoint
+
+  static uint64_t Hash( const std::string& str );  // FNV-1a, e.g. of the run configuration
+
+  uint64_t config;  // Hash of the run configuration: a checkpoint of another configuration is not resumed
+  int64_t  entry;
+  uint64_t iEvt;
+  uint64_t iEvtZB;
+  uint64_t n_rows;
+  uint64_t bytes;
+
+}; // End struct FeatureCheckpoint
+
+
+// Concatenate the shards 0 - N-1 of one run (in any order in in_files) into a file with global ordinals:
+// iEvt of the rows of shard i is offset by the MC events of shards 0 - i-1.  False if a shard is missing,
+// duplicated, from another run configuration, or truncated.
+bool MergeFeatureShards( const std::vector<TString>& in_files, const TString out_file );
+
+#endif
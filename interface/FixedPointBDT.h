@@ -0,0 +1,79 @@
+#ifndef EMTFPtAssign2017_FixedPointBDT_h
+#define EMTFPtAssign2017_FixedPointBDT_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Integer-only evaluation of a TMVA regression BDT (BDTG), matching the precision of the pT LUT.
+// The inputs are the integer, bit-compressed variables from PtLutVarCalc (BIT_COMP = true), so every
+// TMVA cut "x >= cut" is exactly equivalent to "x >= ceil(cut)" and the thresholds can be stored as ints.
+// Leaf responses are rounded once to fixed-point with FRAC_BITS fractional bits and summed as integers,
+// so the result does not depend on the order of evaluation, on the compiler, or on float rounding.
+// The final sum is converted to the integer pT word written into the LUT (OUT_BITS wide, PT_LSB GeV per count).
+
+class FixedPointBDT {
+
+ public:
+
+  // Regression target the forest was trained on, from the TMVA target name (GEN_pt_trg or its inv_ / log2_ / sqrt_ forms)
+  enum TargType { kInvPt = 0, kLog2Pt = 1, kSqrtPt = 2, kPt = 3 };
+
+  // Default constructor
+  FixedPointBDT( int _frac_bits = 16, int _out_bits = 9, int _lsb_shift = 1 ) {
+    frac_bits = _frac_bits;
+    out_bits  = _out_bits;
+    lsb_shift = _lsb_shift;
+    targ_type = kInvPt;
+    offset    = 0;
+  } // End default constructor FixedPointBDT()
+
+  // Read the forest from a TMVA weight file (e.g. weights/f_MODE_15_..._BDTG_AWB_Sq.weights.xml)
+  bool ReadWeightFile( const std::string file_name );
+
+  // Fixed-point sum of the leaf responses (FRAC_BITS fractional bits) for one track
+  int64_t EvalSum( const int* vars ) const;
+  int64_t EvalSum( const std::vector<int>& vars ) const { return EvalSum( vars.data() ); }
+
+  // Integer pT word stored in the LUT, in units of PT_LSB = 2^-LSB_SHIFT GeV, saturated at 2^OUT_BITS - 1
+  int EvalPtWord( const int* vars ) const;
+  int EvalPtWord( const std::vector<int>& vars ) const { return EvalPtWord( vars.data() ); }
+
+  // Same, converted back to GeV
+  double EvalPt( const int* vars ) const { return PtFromWord( EvalPtWord(vars) ); }
+  double EvalPt( const std::vector<int>& vars ) const { return EvalPt( vars.data() ); }
+
+  int    WordFromSum( const int64_t sum ) const;
+  double PtFromWord ( const int word ) const { return double(word) / (1 << lsb_shift); }
+  double SumToDouble( const int64_t sum ) const { return double(sum) / (int64_t(1) << frac_bits); }
+
+  int NTrees() const { return int(tree_roots.size()); }
+  int NNodes() const { return int(node_var.size()); }
+  int NVars () const { return int(var_names.size()); }
+
+  // Index of a variable in the input array, or -1 if the forest does not use it
+  int VarIndex( const std::string name ) const;
+
+  int frac_bits;  // Fractional bits in the leaf responses and the sum
+  int out_bits;   // Width of the pT word stored in the LUT
+  int lsb_shift;  // pT word LSB is 2^-LSB_SHIFT GeV (1 --> 0.5 GeV, as in the GMT pT scale)
+
+  int targ_type;
+  std::string method_name;
+  std::string targ_name;
+  std::vector<std::string> var_names;  // Input order expected by EvalSum()
+
+  // Flattened forest: one entry per node, children stored as node indices.
+  // Leaves have node_var = -1 and the fixed-point response in node_val;
+  // internal nodes go to node_right if (x >= node_val) == node_cut_type.
+  int64_t offset;                    // fBoostWeights[0]: initial response of the gradient boost
+  std::vector<int>     tree_roots;
+  std::vector<int>     node_var;
+  std::vector<int>     node_cut_type;
+  std::vector<int>     node_left;
+  std::vector<int>     node_right;
+  std::vector<int64_t> node_val;
+
+}; // End class FixedPointBDT
+
+#endif
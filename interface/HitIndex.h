@@ -0,0 +1,69 @@
+#ifndef EMTFPtAssign2017_HitIndex_h
+#define EMTFPtAssign2017_HitIndex_h
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+class TBranch;
+
+// Per-event index of the EMTF ntuple hits (format in interface/PtLutInputBranches.hh), for the drivers
+// which match the LCTs of an EMTF track to the hit collection.  Fill() reads the hit branch once per
+// event and keys every hit by (sector_index, station, phi_int, theta_int, isRPC, eta > 0); FillTracks()
+// caches the station hits of the EMTF tracks, so TrackHit() finds the hit of a track LCT in O(1)
+// instead of a scan over all hits for each muon.  The per-hit values stay available to the caller.
+
+class HitIndex {
+
+ public:
+
+  // Default constructor
+  HitIndex() {
+  } // End default constructor HitIndex()
+
+  // Index the nHits hits of the current event, replacing the previous event
+  void Fill( TBranch* hit_br, const int nHits );
+
+  // Cache the 4 station hits (4*iTrk + iSt) of the nTrks EMTF tracks of the current event
+  void FillTracks( TBranch* trk_br, const int nTrks );
+
+  // Last hit with these values (the one a scan in hit order would keep), or -1
+  int Find( const int _sector_index, const int _station, const int _phi_int, const int _theta_int,
+	    const bool _isRPC, const bool _eta_pos ) const;
+
+  // Hit of station hit id = 4*iTrk + iSt of an EMTF track, among the hits of the eta_pos endcap, or -1
+  int TrackHit( const int id, const bool _eta_pos ) const {
+    return Find( trk_sector_index.at(id), id % 4 + 1, trk_phi_int.at(id), trk_theta_int.at(id), trk_isRPC.at(id), _eta_pos );
+  }
+
+  int NHits() const { return int(station.size()); }
+
+  // Hit values, by hit index
+  std::vector<int>  sector_index;
+  std::vector<int>  station;
+  std::vector<int>  phi_int;
+  std::vector<int>  theta_int;
+  std::vector<char> isRPC;
+  std::vector<char> eta_pos;   // eta > 0
+
+  // EMTF track station hits, by 4*iTrk + iSt
+  std::vector<int>  trk_sector_index;
+  std::vector<int>  trk_phi_int;
+  std::vector<int>  trk_theta_int;
+  std::vector<char> trk_isRPC;
+
+ private:
+
+  // Exact for sector_index, station < 64 and 0 <= theta_int < 65536; Find() checks the values anyway
+  static uint64_t Key( const int _sector_index, const int _station, const int _phi_int, const int _theta_int,
+		       const bool _isRPC, const bool _eta_pos ) {
+    return ( (uint64_t(uint32_t(_phi_int)) << 32) | (uint64_t(uint16_t(_theta_int)) << 16) |
+	     (uint64_t(_sector_index & 0x3f) << 8) | (uint64_t(_station & 0x3f) << 2) | (_isRPC << 1) | _eta_pos );
+  }
+
+  std::unordered_map<uint64_t, int> last;  // Last hit of each key
+  std::vector<int> prev;                    // Previous hit with the same key, or -1
+
+}; // End class HitIndex
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef EMTFPtAssign2017_KFoldTrainer_h
+#define EMTFPtAssign2017_KFoldTrainer_h
+
+#include <vector>
+#include <map>
+#include <string>
+
+#include "TString.h"
+
+namespace TMVA {
+  class Factory;
+  class DataLoader;
+}
+
+// k-fold cross-validation of the regressions of one factory.  Tracks are kept in memory once, each
+// assigned to a fold by a hash of its event number, so all tracks of an event (and the same event in
+// every factory) share a fold.  Run() forks one process per fold, up to n_procs at a time: each trains
+// the booked methods on the other k - 1 folds, from the parent's feature set shared copy-on-write,
+// and scores its own fold with GetResScore() on log2(trigger pT / GEN pT), as in macros/PtResolution.C.
+// The mean and spread of the score over the folds is printed for each method.
+
+class KFoldTrainer {
+
+ public:
+
+  typedef void (*BookFunc)( TMVA::Factory*, TMVA::DataLoader*, std::map<std::string, int>& );
+
+  // var_names: input variables, then targets, in the order given to the DataLoader (spectators are not kept)
+  KFoldTrainer( const TString _name, const std::vector<TString>& _var_names, const int _n_in, const int _n_targ,
+		const int _k, const int _n_procs = 4 ) {
+    name      = _name;
+    var_names = std::vector<TString>( _var_names.begin(), _var_names.begin() + _n_in + _n_targ );
+    n_in      = _n_in;
+    n_targ    = _n_targ;
+    k         = _k;
+    n_procs   = _n_procs;
+  } // End constructor KFoldTrainer()
+
+  // Fold of an event, from 0 to k - 1
+  static int Fold( const ULong64_t event_id, const int k );
+
+  // Values as passed to DataLoader::AddTrainingEvent(); only the inputs and targets are stored
+  void AddEvent( const ULong64_t event_id, const std::vector<Double_t>& var_vals, const Double_t weight );
+
+  // Train and score all folds: TMVA output in out_dir/<name>_fold<i>.root, weights in <name>_fold<i>/weights.
+  // book books the methods on each fold's factory, as for the full training.  False if a fold failed.
+  bool Run( BookFunc book, std::map<std::string, int>& Use, const TString out_dir );
+
+  Long64_t NEvents() const { return weights.size(); }
+
+  TString name;
+  std::vector<TString> var_names;
+  int n_in;
+  int n_targ;
+  int k;
+  int n_procs;
+
+  // Filled by Run(): methods, and their score in each fold
+  std::vector<TString> method_names;
+  std::vector< std::vector<double> > scores;  // method x fold
+
+ private:
+
+  // Child process: train and score fold iFold, write "method score" lines to fd
+  void RunFold( const int iFold, BookFunc book, std::map<std::string, int>& Use, const TString out_dir, const int fd );
+
+  std::vector<Float_t> values;   // NEvents() x (n_in + n_targ)
+  std::vector<Float_t> weights;
+  std::vector<UChar_t> folds;
+
+}; // End class KFoldTrainer
+
+#endif
@@ -1,3 +1,8 @@
+#ifndef EMTFPtAssign2017_MVA_helper_h
+#define EMTFPtAssign2017_MVA_helper_h
+
+#include "TString.h"
+
 
 // Defines single input variable to MVA in TMVA macro
 class MVA_var {
@@ -22,3 +27,4 @@ class MVA_var {
   
 }; // End class MVA_var
 
+#endif
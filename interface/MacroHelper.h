@@ -1,35 +1,26 @@
+#ifndef EMTFPtAssign2017_MacroHelper_h
+#define EMTFPtAssign2017_MacroHelper_h
 
-Float_t GetMedian(const TH1D* hist);
+#include <vector>
+#include <utility>
 
-void WeightByResScore(TH1D& hist, const Float_t med_ratio);
+#include "TString.h"
+#include "TFile.h"
+#include "TChain.h"
+#include "TH1.h"
+#include "TH2.h"
 
-Float_t GetResScore(const TH1D* hist, const Float_t med_ratio);
+#include "MVA_helper.h"  // MVA_var class
 
-Float_t GetResScoreErr(const TH1D* hist, const Float_t med_ratio);
+class BootHist2D;  // Bootstrap replicas of the counts histograms, from Bootstrap.h
 
+Float_t GetMedian(const TH1D* hist);
 
-// Defines single input variable to MVA in TMVA macro
-class MVA_var {
+void WeightByResScore(TH1D& hist, const Float_t med_ratio);
 
- public:
+Float_t GetResScore(const TH1D* hist, const Float_t med_ratio);
 
-  // Default constructor
-  MVA_var( TString _name = "", TString _descr = "", TString _unit = "", 
-	   char _type = 'F', Double_t _def_val = -99 ) {
-    name    = _name;
-    descr   = _descr;
-    unit    = _unit;
-    type    = _type;
-    def_val = _def_val;
-  } // End default constructor MVA_var()
-
-  TString name;
-  TString descr;
-  TString unit;
-  char type;
-  Double_t def_val;
-  
-}; // End class MVA_var
+Float_t GetResScoreErr(const TH1D* hist, const Float_t med_ratio);
 
 
 // Defines factory-MVA-mode for performance evaluation
@@ -54,6 +45,12 @@ class PtAlgo {
     MVA_name  = "";
     unique_ID = "";
     alias     = "";
+
+    BDT_file_name = "";
+    BDT_frac_bits = 16;
+    BDT_out_bits  = 9;
+
+    LUT_file_name = "";
     
     modes      = {};
     modes_CSC  = {};
@@ -68,6 +65,10 @@ class PtAlgo {
     h_MC_etas  = {};
     h_ZB_etas  = {};
 
+    b_trg_vs_GEN_pt = std::make_pair( (BootHist2D*) 0, (BootHist2D*) 0 );
+    b_ZB_count      = 0;
+    h_boot_bands    = {};
+
   } // End default constructor PtAlgo()
   
   // Input data, from TMVA training output
@@ -82,6 +83,14 @@ class PtAlgo {
   TString unique_ID;
   TString alias;
   float   MVA_val;
+
+  // Fixed-point evaluation of the BDT from its weight file, instead of the TMVA output in MVA_name
+  TString BDT_file_name;  // TMVA weights XML; if empty, read the MVA_name branch
+  int     BDT_frac_bits;  // Fractional bits in the fixed-point leaf sums
+  int     BDT_out_bits;   // Bits in the integer pT word (0.5 GeV LSB), as stored in the LUT
+
+  // Lookup of the pT from a generated LUT at the compressed track address, as in firmware
+  TString LUT_file_name;  // Memory-mapped LUT file; if set, overrides BDT_file_name and MVA_name
   
   // Track modes to test
   std::vector<int> modes;
@@ -107,4 +116,12 @@ class PtAlgo {
   std::vector< std::pair<TH1D*, TH1D*> > h_MC_etas;       // 1D MC rate vs. muon eta for multiple pT thresholds
   std::vector< std::pair<TH1D*, TH1D*> > h_ZB_etas;       // 1D ZeroBias rate vs. muon eta for multiple pT thresholds
   TH1D*                                  h_charge_eff;    // 1D EMTF correct-charge efficiency vs. pT 
+
+  // Poisson bootstrap replicas of h_trg_vs_GEN_pt and h_ZB_count (ZeroBias counts in y, single x bin),
+  // and the 68% bands they give for the rates, pT scales and turn-ons; only booked if N_BOOT > 0
+  std::pair<BootHist2D*, BootHist2D*> b_trg_vs_GEN_pt;
+  BootHist2D*                         b_ZB_count;
+  std::vector<TH1D*>                  h_boot_bands;
 };
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef EMTFPtAssign2017_MulticlassDataset_h
+#define EMTFPtAssign2017_MulticlassDataset_h
+
+#include <vector>
+
+#include "TString.h"
+
+class TFile;
+class TTree;
+
+// Training set of pTMulticlass for several class schemes at once.  A scheme is a list of GEN pT
+// boundaries in decreasing order: class1 has pT >= the first boundary, the last class is below the
+// last one.  Each track is written once, with the input and spectator variables of its factory, its
+// event weight and train / test flag, and one class label per scheme ("class_32_24_16_8", etc.),
+// so every scheme can be trained later from the same file without another pass over the ntuples.
+
+class MulticlassDataset {
+
+ public:
+
+  // Default constructor
+  MulticlassDataset() {
+    tree = 0;
+    iScheme = -1;
+  } // End default constructor MulticlassDataset()
+
+  // Class of a muon with GEN pT pt in the scheme with boundaries bounds, from 1 to bounds.size() + 1
+  static int PtClass( const double pt, const std::vector<double>& bounds );
+
+  // Branch name suffix of a scheme, e.g. "32_24_16_8"
+  static TString SchemeName( const std::vector<double>& bounds );
+
+  // Writing: tree in the current directory
+  void Book( const TString tree_name, const std::vector<TString>& _var_names,
+	     const std::vector< std::vector<double> >& _schemes );
+  void Fill( const std::vector<Double_t>& var_vals, const double pt, const double weight, const bool train );
+  void Write();
+
+  // Reading the labels of one scheme; false if the tree, a variable or the scheme is missing
+  bool Open( TFile* file, const TString tree_name, const std::vector<TString>& _var_names,
+	     const std::vector<double>& scheme );
+  Long64_t Entries() const;
+  // Values, weight and train / test flag of entry iEnt, and its class in the opened scheme
+  int GetEntry( const Long64_t iEnt, std::vector<Double_t>& var_vals, double& weight, bool& train );
+
+  std::vector<TString> var_names;
+  std::vector< std::vector<double> > schemes;
+
+ private:
+
+  TTree* tree;
+  int    iScheme;  // Scheme read by GetEntry()
+  std::vector<Float_t> vals;
+  std::vector<UChar_t> labels;
+  Float_t weight_br;
+  Bool_t  train_br;
+
+}; // End class MulticlassDataset
+
+#endif
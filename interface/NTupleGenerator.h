@@ -0,0 +1,120 @@
+#ifndef EMTFPtAssign2017_NTupleGenerator_h
+#define EMTFPtAssign2017_NTupleGenerator_h
+
+#include <vector>
+#include <random>
+
+#include "TString.h"
+
+// Synthetic EMTF ntuples in the "ntuple/tree" layout of interface/PtLutInputBranches.hh, for
+// benchmarking the drivers and macros on machines without access to the EOS ntuples.
+// Each MC event has one GEN muon (pT spectrum, |eta| range, charge) which bends by charge / pT
+// between stations, with multiple scattering and detector resolution, and leaves a CSC or RPC
+// hit (RPC_FRAC) in each station it reaches (STATION_EFF, which sets the mode mix).  Its hits
+// form the EMTF track, with a smeared pT.  Extra hits come from pileup (N_PU x HITS_PER_PU) and
+// duplicate LCTs (DUP_FRAC).  ZeroBias events have no GEN muon: their tracks come from steeply
+// falling low-pT muons, N_ZB_TRK per event on average.
+// Physics is only approximate: integer phi and theta, chambers, rings and FR bits have the
+// EMTF conventions, so track building, the LUT address and the rate / efficiency macros work as
+// on real ntuples, but resolutions and rates are not meant to be realistic.
+
+class NTupleGenerator {
+
+ public:
+
+  // Array sizes of interface/PtLutInputBranches.hh
+  static const int N_GEN = 2;
+  static const int N_HIT = 24;
+  static const int N_TRK = 4;
+
+  // Branch structs of interface/PtLutInputBranches.hh, without the CMSSW Fill() methods
+  struct GenMuonBranch {
+    int nMuons;
+    float pt[N_GEN], eta[N_GEN], theta[N_GEN], phi[N_GEN];
+    int charge[N_GEN];
+  };
+  struct EMTFHitBranch {
+    int nHits;
+    float eta[N_HIT], theta[N_HIT], phi[N_HIT], phi_loc[N_HIT];
+    int eta_int[N_HIT], theta_int[N_HIT], phi_int[N_HIT];
+    int endcap[N_HIT], sector[N_HIT], sector_index[N_HIT], station[N_HIT], ring[N_HIT];
+    int CSC_ID[N_HIT], chamber[N_HIT], FR[N_HIT], pattern[N_HIT];
+    int roll[N_HIT], subsector[N_HIT], isRPC[N_HIT], vetoed[N_HIT];
+  };
+  struct EMTFTrackBranch {
+    int nTracks;
+    float pt[N_TRK], eta[N_TRK], theta[N_TRK], phi[N_TRK], phi_loc[N_TRK];
+    int pt_int[N_TRK], eta_int[N_TRK], theta_int[N_TRK], phi_int[N_TRK];
+    int endcap[N_TRK], sector[N_TRK], sector_index[N_TRK], mode[N_TRK], charge[N_TRK];
+    int nHits[N_TRK], nRPC[N_TRK];
+    float hit_eta[N_TRK][4], hit_theta[N_TRK][4], hit_phi[N_TRK][4], hit_phi_loc[N_TRK][4];
+    int hit_eta_int[N_TRK][4], hit_theta_int[N_TRK][4], hit_phi_int[N_TRK][4];
+    int hit_endcap[N_TRK][4], hit_sector[N_TRK][4], hit_sector_index[N_TRK][4], hit_station[N_TRK][4], hit_ring[N_TRK][4];
+    int hit_CSC_ID[N_TRK][4], hit_chamber[N_TRK][4], hit_FR[N_TRK][4], hit_pattern[N_TRK][4];
+    int hit_roll[N_TRK][4], hit_subsector[N_TRK][4], hit_isRPC[N_TRK][4], hit_vetoed[N_TRK][4];
+  };
+
+  // Default constructor: settings close to the 2017 single-muon samples
+  NTupleGenerator() {
+    PT_SPECTRUM = "invPt";
+    PT_MIN      = 1.;
+    PT_MAX      = 1000.;
+    ETA_MIN     = 1.2;
+    ETA_MAX     = 2.4;
+    STATION_EFF = {0.95, 0.95, 0.95, 0.92};
+    RPC_FRAC    = 0.1;
+    DUP_FRAC    = 0.05;
+    N_PU        = 40;
+    HITS_PER_PU = 0.05;
+    N_ZB_TRK    = 0.05;
+  } // End default constructor NTupleGenerator()
+
+  TString PT_SPECTRUM;              // "invPt" (flat in 1/pT), "log2Pt" (flat in log2(pT)), or "pt" (flat in pT)
+  double  PT_MIN, PT_MAX;           // GEN muon pT range (GeV)
+  double  ETA_MIN, ETA_MAX;         // GEN muon |eta| range
+  std::vector<double> STATION_EFF;  // Probability of a hit in stations 1 - 4, if the muon reaches them
+  double  RPC_FRAC;                 // Fraction of hits in RPC-equipped rings which are RPC hits
+  double  DUP_FRAC;                 // Fraction of CSC hits with a second LCT in the same chamber
+  double  N_PU;                     // Pileup interactions per event
+  double  HITS_PER_PU;              // Mean random hits per pileup interaction
+  double  N_ZB_TRK;                 // Mean low-pT muons per ZeroBias event
+
+  // Write n_evt events to tree "ntuple/tree" of file_name; seed fixes the events
+  bool Generate( const TString file_name, const Long64_t n_evt, const bool zero_bias, const ULong64_t seed );
+
+  // Events in memory, without writing a file: Seed(), then Next() fills the branch structs
+  void Seed( const ULong64_t seed ) { rng.seed( seed ); gauss.reset(); }
+  void Next( const bool zero_bias ) { Event( zero_bias ); }
+  const GenMuonBranch&   Muons()  const { return muon; }
+  const EMTFHitBranch&   Hits()   const { return hit; }
+  const EMTFTrackBranch& Tracks() const { return track; }
+
+  // Leaf list of each branch, in struct order
+  static TString MuonLeaves();
+  static TString HitLeaves();
+  static TString TrackLeaves();
+
+ private:
+
+  // One event into the branch structs
+  void Event( const bool zero_bias );
+  // Hits of one muon, and its EMTF track if it has hits in two stations
+  void AddMuon( const double pt, const double eta, const double phi, const int charge );
+  // One hit; index in the hit branch, or -1 if the branch is full
+  int AddHit( const int endcap, const int sector, const int station, const int ring, const bool isRPC,
+	      const double phi_glob, const double theta_deg );
+  void AddNoiseHit();
+
+  double Uniform() { return uniform(rng); }
+  double Gauss()   { return gauss(rng); }
+
+  std::mt19937_64 rng;
+  std::uniform_real_distribution<double> uniform;  // [0, 1)
+  std::normal_distribution<double>       gauss;    // Mean 0, sigma 1
+  GenMuonBranch   muon;
+  EMTFHitBranch   hit;
+  EMTFTrackBranch track;
+
+}; // End class NTupleGenerator
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef EMTFPtAssign2017_NTupleInput_h
+#define EMTFPtAssign2017_NTupleInput_h
+
+#include <vector>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "TString.h"
+
+class TChain;
+class TBranch;
+
+// Read-ahead input layer for the EMTF ntuples (format in interface/PtLutInputBranches.hh).
+// NTupleStager copies the next N_AHEAD input files (e.g. from root://eoscms...) to a local scratch
+// directory in a background thread while the current file is processed, and deletes each copy once
+// it has been read.  Any path TFile::Cp understands can be the source, so a local directory can
+// stand in for the remote store.  NTupleInput reads all files through a single TChain, pointing
+// each chain element at its staged copy just before the chain reaches it, with one TTreeCache
+// restricted to the branches the caller actually uses.  Entry ranges aligned on the clusters
+// of the files can be handed to separate workers.
+
+class NTupleStager {
+
+ public:
+
+  // Staging is disabled if _stage_dir is empty: Local() then returns the original file names
+  NTupleStager( const std::vector<TString>& _in_file_names, const TString _stage_dir = "", const int _n_ahead = 2 );
+  ~NTupleStager();
+
+  // Start the background copies (called by NTupleInput, or earlier to overlap with other setup)
+  void Start();
+
+  // Blocks until file iFile is staged; returns the path to open, or "" if the copy failed
+  TString Local( const int iFile );
+
+  // The caller is done with file iFile: delete the local copy and let the stager move ahead
+  void Release( const int iFile );
+
+  int NFiles() const { return int(in_file_names.size()); }
+
+  std::vector<TString> in_file_names;
+  TString stage_dir;
+  int n_ahead;
+
+ private:
+
+  enum Status { kPending = 0, kStaged = 1, kFailed = 2, kReleased = 3 };
+
+  NTupleStager( const NTupleStager& );
+  NTupleStager& operator=( const NTupleStager& );
+
+  void Run();  // Body of the staging thread
+  TString LocalName( const int iFile ) const;
+
+  std::vector<int> status;
+  int n_released;
+  bool stop;
+  bool started;
+  std::thread thread;
+  std::mutex mtx;
+  std::condition_variable cv;
+
+}; // End class NTupleStager
+
+
+class NTupleInput {
+
+ public:
+
+  // Reads _tree_name (e.g. "ntuple/tree") from the files of the stager; only _branch_names are read
+  NTupleInput( NTupleStager& _stager, const TString _tree_name, const std::vector<TString>& _branch_names,
+	       const Long64_t _cache_size = 30000000 );
+  ~NTupleInput();
+
+  // Entries of each input file, if already known (e.g. from NTupleManifest): the chain then never has to
+  // open a file to locate an entry.  Optionally also the global cluster starts, as from Scan().
+  // Must be called before the first NextFile() / Next().
+  void SetFileEntries( const std::vector<Long64_t>& _file_entries,
+		       const std::vector<Long64_t>& _cluster_starts = std::vector<Long64_t>() );
+
+  // Open the header of every input file once, to get its entries and cluster boundaries
+  bool Scan();
+
+  // Split [range_first, range_last) into about n_ranges ranges whose boundaries fall on entry clusters,
+  // so that no basket is read by two workers.  Calls Scan() if needed.
+  void ClusterRanges( const int n_ranges, std::vector< std::pair<Long64_t, Long64_t> >& ranges );
+
+  // Only read global entries [first, last); restricts the TTreeCache to the same range.
+  // Requires the file entries (SetFileEntries() or Scan()), and must be called before the first NextFile() / Next().
+  void SetRange( const Long64_t first, const Long64_t last );
+
+  // Only read these global entries (sorted), e.g. the events of one track mode from NTupleSkim.
+  // Files without any listed entry are never staged.  Requires the file entries, like SetRange().
+  void SetEntryList( const std::vector<Long64_t>& _entry_list );
+
+  // Move to the next file which can be read; false once all files (or the range) are done
+  bool NextFile();
+
+  // Load the next entry of the current file into its branches; false at the end of the file
+  bool NextEvent();
+
+  // Both of the above: load the next entry of any file
+  bool Next();
+
+  // Branch of the current file, among _branch_names (0 if absent).  The chain replaces its
+  // branches on every file switch, so these must be fetched again after each NextFile().
+  TBranch* GetBranch( const TString name ) const;
+
+  TChain* GetChain() const { return chain; }
+
+  int      iFile;     // Index of the current file in the stager list
+  Long64_t entry;     // Global entry in the chain, -1 before the first NextEvent()
+  Long64_t iList;     // Position of the current entry in the entry list, if any
+  Long64_t fileFirst; // Global entries [fileFirst, fileLast) of the current file within the range
+  Long64_t fileLast;
+
+  std::vector<Long64_t> file_entries;   // Entries of each input file, -1 if unknown
+  std::vector<Long64_t> cluster_starts; // Global first entry of each cluster, filled by Scan()
+
+ private:
+
+  NTupleInput( const NTupleInput& );
+  NTupleInput& operator=( const NTupleInput& );
+
+  void BuildChain();
+  bool EntriesKnown() const;
+  int  FileOf( const Long64_t global_entry ) const;
+  Long64_t FileOffset( const int _iFile ) const;
+
+  NTupleStager& stager;
+  TString tree_name;
+  std::vector<TString> branch_names;
+  Long64_t cache_size;
+  Long64_t range_first;
+  Long64_t range_last;
+
+  TChain* chain;
+  std::vector<Long64_t> entry_list;
+  std::vector<int> chain_files;  // Input file of each tree in the chain (files known to be empty are left out)
+  std::vector<TBranch*> branches;
+
+}; // End class NTupleInput
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef EMTFPtAssign2017_NTupleManifest_h
+#define EMTFPtAssign2017_NTupleManifest_h
+
+#include <vector>
+#include <map>
+#include <string>
+
+#include "TString.h"
+
+// List of input ntuple files with what a driver needs to know before reading any event:
+// whether each file opens, its tree entries, branch names and entry-cluster boundaries.
+// Files are checked in parallel threads, and the result is saved to a small text sidecar keyed
+// by path and modification time, so later runs only stat the files and skip the opening.
+
+struct NTupleFileInfo {
+
+  // Default constructor
+  NTupleFileInfo() {
+    mtime   = -1;
+    ok      = false;
+    entries =  0;
+  } // End default constructor NTupleFileInfo()
+
+  std::string path;
+  long        mtime;    // Modification time, -1 if the file could not be stat'ed
+  bool        ok;       // The file opens and holds the tree
+  std::string tree_name;
+  long long   entries;
+  std::vector<std::string> branches;        // Top-level branch names
+  std::vector<long long>   cluster_starts;  // First entry of each cluster, within the file
+
+}; // End struct NTupleFileInfo
+
+
+class NTupleManifest {
+
+ public:
+
+  // Default constructor
+  NTupleManifest( const TString _tree_name = "ntuple/tree", const int _n_threads = 8 ) {
+    tree_name = _tree_name;
+    n_threads = _n_threads;
+    n_cached  = 0;
+  } // End default constructor NTupleManifest()
+
+  // Check all files, reusing the entries of the sidecar (if any) whose path and mtime still match,
+  // and rewrite the sidecar.  An empty _sidecar_name disables the cache.
+  void Build( const std::vector<TString>& file_names, const TString _sidecar_name = "" );
+
+  // Info of a file passed to Build()
+  const NTupleFileInfo& Info( const TString file_name ) const;
+
+  // Remove the files which failed to open, keeping the order
+  std::vector<TString> GoodFiles( const std::vector<TString>& file_names ) const;
+
+  // Entries of each file, e.g. for NTupleInput::SetFileEntries()
+  std::vector<Long64_t> Entries( const std::vector<TString>& file_names ) const;
+
+  // Cluster starts of all files, as global entries of their concatenation, followed by the total entries
+  std::vector<Long64_t> ClusterStarts( const std::vector<TString>& file_names ) const;
+
+  bool Read ( const TString _sidecar_name );
+  bool Write( const TString _sidecar_name ) const;
+
+  TString tree_name;
+  int n_threads;
+  int n_cached;  // Files taken from the sidecar in the last Build()
+
+ private:
+
+  void Check( NTupleFileInfo& info ) const;  // Open one file and fill its info
+
+  std::map<std::string, NTupleFileInfo> files;
+
+}; // End class NTupleManifest
+
+#endif
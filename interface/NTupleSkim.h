@@ -0,0 +1,80 @@
+#ifndef EMTFPtAssign2017_NTupleSkim_h
+#define EMTFPtAssign2017_NTupleSkim_h
+
+#include <vector>
+#include <string>
+
+#include "TString.h"
+
+class TFile;
+class TTree;
+class TBranch;
+
+// Mode-indexed skim of the EMTF ntuples, written once and read by every per-mode training job.
+// For each track mode 0 - 15 a tree "mode_<m>" lists (file, entry) of the events which can yield
+// a built track of that mode, along with the event's ordinal among the MC (or ZeroBias) events of
+// its file, so a job reading only its listed entries can still reproduce the iEvt-based train/test
+// split of a full pass.  A tree "files" indexes the input files with their MC and ZeroBias counts.
+
+// Per-file entry of the index
+struct NTupleSkimFile {
+  std::string path;
+  Long64_t entries;
+  Long64_t nMC;   // Events with GEN muons
+  Long64_t nZB;   // Events without (ZeroBias)
+}; // End struct NTupleSkimFile
+
+
+class NTupleSkim {
+
+ public:
+
+  static const int N_MODE = 16;
+
+  // Default constructor
+  NTupleSkim() {
+    out_file = 0;
+    file_tree = 0;
+  } // End default constructor NTupleSkim()
+
+  ~NTupleSkim() { Close(); }
+
+  // Bit m is set if the event can give a built track of mode m (bit 0: any EMTF track, for MODE = 0).
+  // Conservative: a track of mode m needs hits in each station of m within one endcap, either
+  // in an EMTF track or in the hit collection, and the event needs at least one EMTF track.
+  static int ModeMask( TBranch* hit_br, TBranch* trk_br );
+
+  // Writing
+  bool Create( const TString _file_name );
+  void AddFile( const std::string path, const Long64_t entries, const Long64_t nMC, const Long64_t nZB );
+  void Fill( const int iFile, const Long64_t entry, const Long64_t ordinal, const bool isMC, const int mode_mask );
+  bool Close();
+
+  // Reading: the global entries of the events listed for mode, in the order of file_names (whose
+  // entries are file_entries), with their global MC or ZeroBias ordinals in that same order.
+  // Fails if one of file_names is not in the skim, since the ordinals would then be unknown.
+  bool Select( const TString _file_name, const int mode,
+	       const std::vector<TString>& file_names, const std::vector<Long64_t>& file_entries,
+	       std::vector<Long64_t>& entries, std::vector<Long64_t>& ordinals, std::vector<bool>& isMC ) const;
+
+  std::vector<NTupleSkimFile> files;
+
+ private:
+
+  NTupleSkim( const NTupleSkim& );
+  NTupleSkim& operator=( const NTupleSkim& );
+
+  TFile* out_file;
+  TTree* file_tree;
+  std::vector<TTree*> mode_trees;
+
+  // Branch buffers of the trees being written
+  char     b_path[1024];
+  Long64_t b_entries, b_nMC, b_nZB;
+  Int_t    b_iFile;
+  Long64_t b_entry, b_ordinal;
+  Bool_t   b_isMC;
+
+}; // End class NTupleSkim
+
+#endif
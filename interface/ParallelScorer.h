@@ -0,0 +1,66 @@
+#ifndef EMTFPtAssign2017_ParallelScorer_h
+#define EMTFPtAssign2017_ParallelScorer_h
+
+#include <vector>
+
+#include "TString.h"
+
+class TTree;
+
+// Scores the test sample of one factory with its trained TMVA regression methods, in place of
+// Factory::TestAllMethods().  Test events are stored as they are added to the DataLoader, then
+// split into chunks evaluated in parallel, each thread with its own TMVA::Reader.  WriteTree()
+// writes a TestTree with the same branches as TMVA's (classID, className, variables, targets,
+// spectators, weight, one output per method), as read by macros/RateVsEff.C and PtResolution.C
+
+class ParallelScorer {
+
+ public:
+
+  static const int CHUNK = 10000;  // Events per unit of work
+
+  // var_names: input variables, then targets, then spectators, in the order given to the DataLoader
+  ParallelScorer( const std::vector<TString>& _var_names, const int _n_in, const int _n_targ, const int _n_threads = 8 ) {
+    var_names = _var_names;
+    n_in      = _n_in;
+    n_targ    = _n_targ;
+    n_threads = _n_threads;
+  } // End constructor ParallelScorer()
+
+  // Same values and weight as passed to DataLoader::AddTestEvent()
+  void AddEvent( const std::vector<Double_t>& var_vals, const Double_t weight );
+
+  // Method as booked in the factory, with the weight file written by its training
+  void AddMethod( const TString method_name, const TString weight_file );
+
+  // Evaluate every method on every event; false if a weight file could not be booked
+  bool Score();
+
+  // Write the tree in the current directory
+  void WriteTree( const TString tree_name = "TestTree" ) const;
+
+  // Same tree, filled in memory and not attached to any directory (e.g. for AsyncTreeWriter); owned by the caller
+  TTree* MakeTree( const TString tree_name = "TestTree" ) const;
+
+  Long64_t NEvents() const { return weights.size(); }
+  Float_t  Output( const int iMeth, const Long64_t iEvt ) const { return outputs.at( iMeth * NEvents() + iEvt ); }
+
+  std::vector<TString> var_names;
+  int n_in;
+  int n_targ;
+  int n_threads;
+
+  std::vector<TString> method_names;
+  std::vector<TString> weight_files;
+
+ private:
+
+  void FillTree( TTree* tree ) const;  // Branches and entries of the TestTree
+
+  std::vector<Float_t> values;   // NEvents() x var_names.size()
+  std::vector<Float_t> weights;
+  std::vector<Float_t> outputs;  // method_names.size() x NEvents()
+
+}; // End class ParallelScorer
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef EMTFPtAssign2017_PtAssigner_h
+#define EMTFPtAssign2017_PtAssigner_h
+
+#include <cstdint>
+#include <array>
+#include <vector>
+
+#include "TString.h"
+
+#include "../interface/PtLutAddress.h"   // PtLutAddressVars
+#include "../interface/FixedPointBDT.h"
+
+class PtLutFile;
+
+// Station hits of one track, as input to the pT assignment.  Plain fixed-width fields, so the
+// struct is also the wire format of PtService; stations without a hit are ignored.
+struct PtAssignTrack {
+  int32_t mode;        // 8 * (station 1 hit) + 4 * (station 2) + 2 * (station 3) + (station 4)
+  int32_t endcap;      // +1 or -1
+  int32_t phi[4];      // Full-precision integer phi (phi_int) by station
+  int32_t theta[4];    // Integer theta (theta_int)
+  int32_t pattern[4];  // CSC CLCT pattern, 0 for RPC hits
+  int32_t ring[4];     // Ring: only station 1 is used (St1_ring2)
+  int32_t FR[4];       // Front / rear chamber bit
+  int32_t isRPC[4];    // 1 for an RPC hit
+}; // End struct PtAssignTrack
+
+struct PtAssignResult {
+  int32_t address;     // 30-bit pT LUT address
+  int32_t pt_word;     // LUT / BDT pT word, -1 if no LUT or BDT is loaded for the mode
+  int32_t charge;      // +1 or -1 from the sign of the first dPhi (dPhSign), 0 if undefined
+  float   pt;          // pT in GeV, 0 if pt_word < 0
+}; // End struct PtAssignResult
+
+
+// The per-track part of the chain in the drivers: CalcTrackTheta, CalcDeltaPhis, CalcDeltaThetas,
+// CalcBends and CalcRPCs with BIT_COMP, then CalcPtLutAddress and the pT from the per-mode LUT files of
+// WritePtLut, or from the FixedPointBDT forests (use_BDT).  Assign() works on a batch: all addresses
+// are computed first, then the lookups of each mode go through PtLutFile::LookupWords(), which
+// prefetches ahead.  Assign() is const and may be called from several threads once the models are loaded.
+
+class PtAssigner {
+
+ public:
+
+  // Default constructor
+  PtAssigner() {
+    luts.fill( 0 );
+    use_BDT = false;
+  } // End default constructor PtAssigner()
+
+  ~PtAssigner();
+
+  // LUT file of one mode from WritePtLut, or BDT weight file for one mode
+  bool AddLut( const TString file_name );
+  bool AddBDT( const int mode, const TString weight_file );
+
+  bool HasMode( const int mode ) const;
+
+  // Bit-compressed track variables (with the dPhi sums of mode 15) and dPhSign of one track; returns the LUT address
+  static int CalcVars( const PtAssignTrack& trk, PtLutAddressVars& vars, int& dPhSign );
+
+  void Assign( const PtAssignTrack* trks, const int n, PtAssignResult* results ) const;
+  void Assign( const std::vector<PtAssignTrack>& trks, std::vector<PtAssignResult>& results ) const {
+    results.resize( trks.size() );
+    Assign( trks.data(), int(trks.size()), results.data() );
+  }
+
+  bool use_BDT;  // Evaluate the BDTs instead of looking up the LUTs
+
+ private:
+
+  PtAssigner( const PtAssigner& );
+  PtAssigner& operator=( const PtAssigner& );
+
+  std::array<PtLutFile*, 16>        luts;
+  std::array<FixedPointBDT, 16>     bdts;
+  std::array<std::vector<int>, 16>  bdt_offsets;  // Position of each BDT input among the floats of PtLutAddressVars
+
+}; // End class PtAssigner
+
+#endif
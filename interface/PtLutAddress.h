@@ -0,0 +1,79 @@
+#ifndef EMTFPtAssign2017_PtLutAddress_h
+#define EMTFPtAssign2017_PtLutAddress_h
+
+#include "TString.h"
+#include "TChain.h"
+
+// Builds the 30-bit pT LUT address from the bit-compressed track variables, with the same
+// field layout as calculate_address() in L1Trigger/L1TMuonEndCap/src/PtAssignmentEngine2017.cc
+//   * 4-station (mode 15):  dPhiAB(7) dPhiBC(5) dPhiCD(4) sPhiBC(1) sPhiCD(1) dTheta(2) frA(1) mode15_8b(8), bit 29 set
+//   * 3-station:            dPhiAB(7) dPhiBC(5) sPhiBC(1) dTheta(3) frA(1) [frB(1)] clctA(2) rpc_2b(2) theta(5) mode_ID(2)
+//   * 2-station:            dPhiAB(7) dTheta(3) frA(1) frB(1) clctA(3) clctB(3) theta(5) mode_ID(3)
+// Inputs are the outputs of CalcTrackTheta, CalcDeltaPhis, CalcDeltaThetas, CalcBends and CalcRPCs run with BIT_COMP = true,
+// so dPhi values are already sign-normalized to dPhi(AB) >= 0 and the bends, dThetas and theta are compressed codes.
+
+int CalcPtLutAddress( const int mode, const int theta, const int st1_ring2,
+		      const int dPh12, const int dPh13, const int dPh14, const int dPh23, const int dPh24, const int dPh34,
+		      const int dTh12, const int dTh13, const int dTh14, const int dTh23, const int dTh24, const int dTh34,
+		      const int FR1, const int FR2, const int FR3, const int FR4,
+		      const int bend1, const int bend2, const int bend3, const int bend4,
+		      const int RPC1, const int RPC2, const int RPC3, const int RPC4 );
+
+// 2- or 3-bit mode ID stored in the top bits of the address, below the 4-station bit
+int PtLutModeID( const int mode );
+
+// Track mode encoded in an address, or -1 if the address is below the 2-station range
+int PtLutModeFromAddress( const int address );
+
+// Contiguous block of addresses [addr_min, addr_min + n_addr) used by one track mode
+void PtLutAddressRange( const int mode, int& addr_min, int& n_addr );
+
+
+// Compressed variables entering the LUT address, read back from a TMVA TrainTree / TestTree.
+// Branches missing from the tree (not in the factory hex mask) keep their default of -99, and Address()
+// returns -1, matching no LUT entry, for the modes whose address needs one of them.
+// UnpackPtLutAddress() fills the same variables, plus the derived dPhi sums, from an address.
+class PtLutAddressVars {
+
+ public:
+
+  // Default constructor
+  PtLutAddressVars() {
+    theta = -99; St1_ring2 = -99;
+    dPhi_12 = -99; dPhi_13 = -99; dPhi_14 = -99; dPhi_23 = -99; dPhi_24 = -99; dPhi_34 = -99;
+    dTh_12  = -99; dTh_13  = -99; dTh_14  = -99; dTh_23  = -99; dTh_24  = -99; dTh_34  = -99;
+    FR_1   = -99; FR_2   = -99; FR_3   = -99; FR_4   = -99;
+    bend_1 = -99; bend_2 = -99; bend_3 = -99; bend_4 = -99;
+    RPC_1  = -99; RPC_2  = -99; RPC_3  = -99; RPC_4  = -99;
+    dPhiSum4 = -99; dPhiSum4A = -99; dPhiSum3 = -99; dPhiSum3A = -99; outStPhi = -99;
+    missing = 0;
+  } // End default constructor PtLutAddressVars()
+
+  // Set addresses of all branches present in the chain, with an ERROR for each LUT mode (mode, or all
+  // modes for 0) whose address needs a missing branch; false if mode > 0 is one of them
+  bool SetBranches( TChain* chain, const int mode = 0 );
+
+  // LUT address of the current variables, or -1 if a variable it needs was not read from the tree
+  int Address( const int mode ) const;
+
+  // Pointer to the member with a TMVA input variable name (e.g. "dPhi_12"), or 0 if unknown
+  float* Find( const TString name );
+
+  float theta, St1_ring2;
+  float dPhi_12, dPhi_13, dPhi_14, dPhi_23, dPhi_24, dPhi_34;
+  float dTh_12,  dTh_13,  dTh_14,  dTh_23,  dTh_24,  dTh_34;
+  float FR_1,   FR_2,   FR_3,   FR_4;
+  float bend_1, bend_2, bend_3, bend_4;
+  float RPC_1,  RPC_2,  RPC_3,  RPC_4;
+  float dPhiSum4, dPhiSum4A, dPhiSum3, dPhiSum3A, outStPhi;  // Not in the address, only filled on unpacking
+
+  UInt_t missing;  // Address variables not read from the tree, one bit each in SetBranches() order
+
+}; // End class PtLutAddressVars
+
+// Inverse of CalcPtLutAddress(): the track variables as seen by the BDT for every track with this address.
+// dPhi values are the non-linear bin edges (getdPhiFromBin); bends, dThetas and theta are compressed codes.
+// Returns the track mode, or -1 if the address does not belong to any mode.
+int UnpackPtLutAddress( const int address, PtLutAddressVars& vars );
+
+#endif
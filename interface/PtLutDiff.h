@@ -0,0 +1,81 @@
+#ifndef EMTFPtAssign2017_PtLutDiff_h
+#define EMTFPtAssign2017_PtLutDiff_h
+
+#include <cstdint>
+#include <vector>
+
+#include "PtLutFile.h"
+
+// Address-by-address comparison of two binary pT LUTs (e.g. before and after a retraining).
+// The packed entries of both files are scanned in parallel threads, comparing whole 64-bit words
+// so that unchanged regions cost one XOR per word; only the entries of differing words are decoded,
+// with UnpackPtLutAddress(), and accumulated in dense per-thread tables which are merged at the end.
+// Files storing different addresses (e.g. a sparse and a dense LUT) are compared address by address,
+// over the addresses reachable in both.
+
+// One changed address, with the pT words (not GeV) in the two LUTs
+struct PtLutShift {
+  int address;
+  int word_A;
+  int word_B;
+  int Shift()    const { return word_B - word_A; }
+  int AbsShift() const { return (word_B > word_A ? word_B - word_A : word_A - word_B); }
+}; // End struct PtLutShift
+
+
+class PtLutDiff {
+
+ public:
+
+  static const int N_MODE  =  16;  // Track mode 0 - 15
+  static const int N_THETA =  32;  // Compressed theta code (4 or 5 bits)
+  static const int N_RPC   =  16;  // RPC_1*8 + RPC_2*4 + RPC_3*2 + RPC_4
+  static const int N_DPHI  = 128;  // 7-bit dPhi(AB) bin, the lowest field in every address layout
+  static const int MAX_SHIFT = 256; // Shift histogram covers [-MAX_SHIFT, +MAX_SHIFT] words, with overflow in the edges
+
+  // Default constructor
+  PtLutDiff( int _n_top = 100, int _n_threads = 8 ) {
+    n_top     = _n_top;
+    n_threads = _n_threads;
+    Reset();
+  } // End default constructor PtLutDiff()
+
+  void Reset();
+
+  // Compare all addresses covered by either LUT; an address missing from one file counts as word 0
+  bool Compare( const PtLutFile& lut_A, const PtLutFile& lut_B );
+
+  // Accumulate one changed address
+  void Add( const int address, const int word_A, const int word_B );
+
+  // Add another accumulator's counts and keep the overall top N shifts
+  void Merge( const PtLutDiff& other );
+
+  int n_top;
+  int n_threads;
+
+  uint64_t n_compared;
+  uint64_t n_changed;
+
+  // Changed addresses per mode and category, index [mode * N_X + x]
+  std::vector<uint64_t> n_changed_mode;
+  std::vector<uint64_t> n_changed_theta;
+  std::vector<uint64_t> n_changed_RPC;
+  std::vector<uint64_t> n_changed_dPhi;
+  std::vector<double>   sum_shift_theta;  // Summed (B - A) words, for the mean shift in each category
+  std::vector<double>   sum_shift_RPC;
+  std::vector<double>   sum_shift_dPhi;
+
+  // Distribution of (B - A) per mode, index [mode * (2*MAX_SHIFT + 1) + shift + MAX_SHIFT]
+  std::vector<uint64_t> shift_hist;
+
+  // Largest |B - A| shifts, sorted in decreasing order after Compare()
+  std::vector<PtLutShift> top;
+
+ private:
+
+  void PushTop( const PtLutShift& shift );
+
+}; // End class PtLutDiff
+
+#endif
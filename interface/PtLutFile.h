@@ -0,0 +1,202 @@
+#ifndef EMTFPtAssign2017_PtLutFile_h
+#define EMTFPtAssign2017_PtLutFile_h
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Versioned binary pT LUT, designed to be memory-mapped read-only:
+//   * a fixed-size PtLutHeader (magic, version, track mode, address layout, pT encoding)
+//   * the pT words of addresses [addr_min, addr_min + n_entries), ENTRY_BITS each,
+//     bit-packed little-endian into 64-bit words starting at the page-aligned data_offset
+//   * since version 2, optionally sparse: the addresses [addr_min, addr_min + n_addresses) are cut into
+//     ranges of 2^range_bits, and a table of remap_size int32 ranks at remap_offset gives the position of
+//     each range among the stored ones, or -1 for ranges no track can reach (PtLutReach)
+// Opening a LUT maps it without reading it, so the load time does not depend on its size,
+// and every process on a node using the same file shares a single copy in the page cache.
+
+const char     PT_LUT_MAGIC[8] = {'E', 'M', 'T', 'F', 'P', 'T', 'L', 'T'};
+const uint32_t PT_LUT_VERSION  = 2;  // Version 1 files (always dense) are still read
+
+struct PtLutHeader {
+
+  enum Layout     { kLayout2017 = 1 };  // Address fields from CalcPtLutAddress()
+  enum PtEncoding { kPtLinear   = 1 };  // pT = word * 2^-LSB_SHIFT GeV, word 0 for empty entries
+
+  char     magic[8];         // PT_LUT_MAGIC
+  uint32_t version;          // PT_LUT_VERSION of the writer
+  uint32_t header_size;      // sizeof(PtLutHeader) of the writer
+  int32_t  mode;             // Track mode of the entries, or 0 if the LUT covers all modes
+  uint32_t addr_bits;        // Width of the address (30 for kLayout2017)
+  uint32_t layout;           // Layout of the address fields
+  uint32_t entry_bits;       // Width of one packed pT word (1 - 16)
+  uint32_t pt_encoding;      // Meaning of the pT word
+  int32_t  lsb_shift;        // pT word LSB is 2^-LSB_SHIFT GeV
+  uint64_t addr_min;         // First address covered
+  uint64_t n_entries;        // Number of addresses stored
+  uint64_t data_offset;      // Byte offset of the packed entries from the start of the file
+  uint64_t data_size;        // Bytes of packed entries, including one 64-bit word of padding
+  char     description[192]; // Free text: factory, weight file, date, ...
+  // Version 2
+  uint64_t n_addresses;      // Number of addresses covered; n_entries if dense
+  uint64_t remap_offset;     // Byte offset of the rank of each range, 0 if dense
+  uint32_t remap_size;       // Number of ranges, 0 if dense
+  uint32_t range_bits;       // A range is 2^range_bits consecutive addresses
+
+}; // End struct PtLutHeader
+
+
+// Position of an address among the stored entries, or -1 if it is not stored
+inline int64_t PtLutEntryIndex( const PtLutHeader& header, const int32_t* ranks, const int address ) {
+  uint64_t idx = uint64_t(address) - header.addr_min;
+  if (address < 0 || idx >= header.n_addresses) return -1;
+  if (ranks == 0) return int64_t(idx);
+  int32_t rank = ranks[idx >> header.range_bits];
+  if (rank < 0) return -1;
+  return int64_t( (uint64_t(rank) << header.range_bits) | (idx & ((uint64_t(1) << header.range_bits) - 1)) );
+}
+
+
+// Read-only view of a LUT file
+class PtLutFile {
+
+ public:
+
+  // Default constructor
+  PtLutFile() {
+    data     = 0;
+    ranks    = 0;
+    map_addr = 0;
+    map_size = 0;
+    mask     = 0;
+  } // End default constructor PtLutFile()
+
+  ~PtLutFile() { Close(); }
+
+  bool Open( const std::string _file_name );
+  void Close();
+  bool IsOpen() const { return (data != 0); }
+
+  // Hint the kernel about the coming access pattern: random lookups (default) or a full scan
+  void Advise( const bool sequential ) const;
+
+  // pT word stored at an address, or 0 if the address is not covered by the file or unreachable
+  int LookupWord( const int address ) const {
+    int64_t idx = PtLutEntryIndex( header, ranks, address );
+    return (idx < 0 ? 0 : WordAt(idx));
+  }
+  double Lookup( const int address ) const { return PtFromWord( LookupWord(address) ); }
+
+  // Batched lookups: prefetches the cache lines of later addresses while resolving earlier ones
+  void LookupWords( const int* addresses, const int n, int* words ) const;
+  void Lookup     ( const int* addresses, const int n, double* pts ) const;
+
+  double PtFromWord( const int word ) const { return double(word) / (1 << header.lsb_shift); }
+
+  bool IsSparse() const { return (ranks != 0); }
+  int64_t EntryIndex( const int address ) const { return PtLutEntryIndex( header, ranks, address ); }
+  // In the address range of the file, but in a range left out as unreachable
+  bool Unreachable( const int address ) const {
+    return ( ranks != 0 && address >= 0 && uint64_t(address) - header.addr_min < header.n_addresses &&
+	     ranks[(uint64_t(address) - header.addr_min) >> header.range_bits] < 0 );
+  }
+  // Address of the idx-th stored entry
+  int AddressAt( const uint64_t idx ) const {
+    if (ranks == 0) return int(header.addr_min + idx);
+    const uint64_t low = idx & ((uint64_t(1) << header.range_bits) - 1);
+    return int( header.addr_min + ((uint64_t(ranges[idx >> header.range_bits]) << header.range_bits) | low) );
+  }
+  // Same stored addresses as another file, so that entry idx of both holds the same address
+  bool SameEntries( const PtLutFile& other ) const;
+
+  // Word of the idx-th stored entry, without range check
+  int WordAt( const uint64_t idx ) const {
+    uint64_t bit = idx * header.entry_bits;
+    uint64_t w   = bit >> 6;
+    int      off = bit & 63;
+    // The second word is always readable (padding); its shift is split in two so that off = 0 is well defined
+    return int( ((data[w] >> off) | ((data[w+1] << 1) << (63 - off))) & mask );
+  }
+
+  // Raw packed entries, e.g. for word-by-word comparison of two LUTs with the same header
+  const uint64_t* Data() const { return data; }
+  uint64_t NDataWords() const { return header.data_size / sizeof(uint64_t); }
+
+  std::string file_name;
+  PtLutHeader header;
+
+ private:
+
+  // Non-copyable: owns the mapping
+  PtLutFile( const PtLutFile& );
+  PtLutFile& operator=( const PtLutFile& );
+
+  const uint64_t* data;
+  const int32_t*  ranks;   // Remap table in the mapping, 0 if dense
+  std::vector<uint32_t> ranges;  // Range of each rank (inverse of ranks)
+  void*    map_addr;
+  size_t   map_size;
+  uint64_t mask;
+
+}; // End class PtLutFile
+
+
+// Creates a LUT file and fills it in place through a shared writable mapping.
+// The file is written as <name>.tmp and renamed on Close(), so readers never map a partial LUT.
+// Entries are zero until set; Set() on different 64-entry blocks may be called from different threads.
+// A sparse LUT stores only the ranges with a rank >= 0 (PtLutReach::ranks); Set() ignores the other addresses.
+class PtLutWriter {
+
+ public:
+
+  // Default constructor
+  PtLutWriter() {
+    data     = 0;
+    map_addr = 0;
+    map_size = 0;
+    mask     = 0;
+  } // End default constructor PtLutWriter()
+
+  ~PtLutWriter() { Close(); }
+
+  // Fill mode, addr_bits, entry_bits, lsb_shift, addr_min, n_entries and description; for a sparse
+  // LUT pass the ranks and fill n_addresses and range_bits instead of n_entries.
+  // The remaining header fields are set here.
+  bool Create( const std::string _file_name, const PtLutHeader& _header,
+	       const std::vector<int>& _ranks = std::vector<int>() );
+  bool Close();
+
+  void Set( const int address, const int word ) {
+    int64_t idx = PtLutEntryIndex( header, (ranks.empty() ? 0 : ranks.data()), address );
+    if (idx >= 0) SetEntry( idx, word );
+  }
+
+  // Set the idx-th stored entry, e.g. with the address from PtLutReach::Address(idx)
+  void SetEntry( const uint64_t idx, const int word ) {
+    uint64_t bit  = idx * header.entry_bits;
+    uint64_t w    = bit >> 6;
+    int      off  = bit & 63;
+    uint64_t val  = (word < 0 ? 0 : (uint64_t(word) > mask ? mask : uint64_t(word)));
+    data[w] = (data[w] & ~(mask << off)) | (val << off);
+    if (off + header.entry_bits > 64)  // Only touch the next word when the entry straddles it
+      data[w+1] = (data[w+1] & ~(mask >> (64 - off))) | (val >> (64 - off));
+  }
+
+  std::string file_name;
+  PtLutHeader header;
+
+ private:
+
+  PtLutWriter( const PtLutWriter& );
+  PtLutWriter& operator=( const PtLutWriter& );
+
+  uint64_t* data;
+  std::vector<int32_t> ranks;
+  void*     map_addr;
+  size_t    map_size;
+  uint64_t  mask;
+
+}; // End class PtLutWriter
+
+#endif
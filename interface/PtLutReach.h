@@ -0,0 +1,49 @@
+#ifndef EMTFPtAssign2017_PtLutReach_h
+#define EMTFPtAssign2017_PtLutReach_h
+
+#include <cstdint>
+#include <vector>
+
+// Reachable part of the LUT address space of one track mode.
+// The upper address fields are packed from a few discrete inputs (mode15_8b from get8bMode15, or
+// clct / rpc_2b / theta), and getTheta clamping, CalcRPCs masking and the pattern-to-bend maps leave
+// many of their bit combinations unused.  Build() runs every combination of those inputs (theta_int,
+// station-1 ring, RPC flags, CLCT patterns, endcap, dPhi sign) through PtAssigner::CalcVars and keeps
+// the upper-field values which occur.  The lower fields (dPhi bins and signs, dTheta, FR) are kept
+// whole, so every reachable address lies in one of the ranges of 2^range_bits consecutive addresses
+// below a reachable upper value: a superset of the addresses tracks can produce.
+
+class PtLutReach {
+
+ public:
+
+  // Default constructor
+  PtLutReach() {
+    mode       = -1;
+    addr_min   =  0;
+    n_addr     =  0;
+    range_bits =  0;
+  } // End default constructor PtLutReach()
+
+  // Enumerate the upper-field inputs of a 2-, 3- or 4-station mode; false for other modes
+  bool Build( const int _mode );
+
+  // Address of the idx-th reachable address, in increasing order
+  int Address( const uint64_t idx ) const {
+    const uint64_t low = idx & ((uint64_t(1) << range_bits) - 1);
+    return addr_min + int( (uint64_t(ranges[idx >> range_bits]) << range_bits) | low );
+  }
+
+  uint64_t NReachable() const { return uint64_t(ranges.size()) << range_bits; }
+  void Print() const;
+
+  int mode;
+  int addr_min;            // Address range of the mode, from PtLutAddressRange()
+  int n_addr;
+  int range_bits;          // Width of the lower fields: a range is 2^range_bits addresses
+  std::vector<int> ranks;  // Rank of each upper-field value (address - addr_min) >> range_bits among the reachable ones, or -1
+  std::vector<int> ranges; // Reachable upper-field values, in increasing order (inverse of ranks)
+
+}; // End class PtLutReach
+
+#endif
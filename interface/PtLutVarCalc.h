@@ -1,3 +1,6 @@
+#ifndef L1TMuonEndCap_PtLutVarCalc_h
+#define L1TMuonEndCap_PtLutVarCalc_h
+
 
 int CalcTrackTheta( const int th1, const int th2, const int th3, const int th4,
                     const int ring1, const int mode, const bool BIT_COMP=false );
@@ -21,3 +24,4 @@ int CalcBendFromPattern( const int pattern, const int endcap );
 void CalcDeltaPhiSums( int& dPhSum4, int& dPhSum4A, int& dPhSum3, int& dPhSum3A, int& outStPh,
                        const int dPh12, const int dPh13, const int dPh14, const int dPh23, const int dPh24, const int dPh34 );
 
+#endif
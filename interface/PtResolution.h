@@ -1,3 +1,5 @@
+class DenseHist;  // Contiguous histogram store, from DenseHist.h
+
 
 void BookScoreHist( const int iFM, const int iMVA,
                     const std::vector<std::tuple<TString, float, float, TString>> pt_bins,
@@ -15,7 +17,9 @@ void LoopOverEvents( TChain* chain, const TString ft_name, const TString trgPt,
                      const std::vector<std::tuple<TString, float, float, TString>> pt_bins,
                      const std::vector<std::tuple<TString, float, float, TString>> eta_bins,
                      std::vector<std::tuple<TString, float, float, float>>& MVAs,
-                     std::vector< std::vector< std::vector< std::vector< std::pair<TH1D*, TH1D*> > > > >& h_res );
+                     DenseHist& res_store );
+
+int ResIndex( const int iMVA, const int iPt, const int iEta, const int num_pt, const int num_eta );
 
 void StoreMedians( const TString ft_name, const int iFM, 
 		   const std::vector<std::tuple<TString, float, float, TString>> pt_bins,
@@ -0,0 +1,111 @@
+#ifndef EMTFPtAssign2017_PtService_h
+#define EMTFPtAssign2017_PtService_h
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+#include "../interface/PtAssigner.h"
+
+// Local pT assignment service, so that re-emulation jobs on one machine share a single copy of the
+// LUTs / BDTs and of the variable code.  PtServer owns nothing but a loaded PtAssigner, and answers
+// on a Unix stream socket (no network, access controlled by the socket file permissions).
+// Each client connection is served by its own thread; one request is one batch of tracks:
+//   request:  PtServiceHeader (n = number of tracks), then n PtAssignTrack
+//   response: PtServiceHeader (n, status), then n PtAssignResult if status is kOK or kBadTrack
+// Tracks with a bad mode, endcap, pattern, phi, theta, FR, isRPC or station 1 ring are not assigned (kBadTrack):
+// their results have address -1, charge 0 and pt_word -1, like tracks from a single station.
+// All fields are native-endian fixed-width integers, as client and server run on the same machine.
+// A client sends its tracks in batches of up to MAX_BATCH: the server computes the addresses of a whole
+// batch before the LUT lookups (PtAssigner::Assign), and the socket round trip is paid once per batch.
+
+const uint32_t PT_SERVICE_MAGIC   = 0x54504d45;  // "EMPT"
+const uint32_t PT_SERVICE_VERSION = 1;
+
+struct PtServiceHeader {
+
+  enum Status { kOK = 0, kBadHeader = 1, kTooLarge = 2, kBadTrack = 3 };
+
+  uint32_t magic;    // PT_SERVICE_MAGIC
+  uint32_t version;  // PT_SERVICE_VERSION
+  uint32_t n;        // Tracks in the batch
+  uint32_t status;   // Status of the response, 0 in requests
+
+}; // End struct PtServiceHeader
+
+
+class PtServer {
+
+ public:
+
+  static const uint32_t MAX_BATCH = 1 << 20;  // Largest batch accepted, in tracks
+
+  PtServer( const PtAssigner& _assigner, const std::string _socket_path ) : assigner(_assigner) {
+    socket_path = _socket_path;
+    listen_fd   = -1;
+    stop        = false;
+    n_batches   = 0;
+    n_tracks    = 0;
+  } // End constructor PtServer()
+
+  ~PtServer();
+
+  // Create the socket (replacing a stale socket file) and serve clients until Stop(); false if the socket could not be set up
+  bool Run();
+
+  // Stop accepting clients and return from Run() once the current batches are answered.
+  // Only sets a flag and shuts the listening socket down, so it can be called from a signal handler.
+  void Stop();
+
+  std::string socket_path;
+  std::atomic<Long64_t> n_batches;
+  std::atomic<Long64_t> n_tracks;
+
+ private:
+
+  PtServer( const PtServer& );
+  PtServer& operator=( const PtServer& );
+
+  void Serve( const int fd );  // Body of the thread of one client
+
+  const PtAssigner& assigner;
+  int listen_fd;
+  std::atomic<bool> stop;
+  std::mutex mtx;
+  std::vector<std::thread> threads;
+  std::vector<int> client_fds;
+
+}; // End class PtServer
+
+
+class PtClient {
+
+ public:
+
+  // Default constructor
+  PtClient() {
+    fd = -1;
+  } // End default constructor PtClient()
+
+  ~PtClient() { Close(); }
+
+  bool Connect( const std::string socket_path );
+  void Close();
+  bool IsConnected() const { return (fd >= 0); }
+
+  // pT, charge and address of each track; batches larger than PtServer::MAX_BATCH are split
+  bool Assign( const std::vector<PtAssignTrack>& trks, std::vector<PtAssignResult>& results );
+
+ private:
+
+  PtClient( const PtClient& );
+  PtClient& operator=( const PtClient& );
+
+  int fd;
+
+}; // End class PtClient
+
+#endif
@@ -18,3 +18,9 @@ void BookPtScaleHist( PtAlgo& algo, const int iEff, const int eff_cut);
 void BookRateHist( PtAlgo& algo, const int iEff, const int eff_cut);
 
 void LoopOverEvents( PtAlgo& algo, const TString tr_te );
+
+void BookBootHist( PtAlgo& algo );
+
+void BootstrapBands( PtAlgo& algo, const std::vector<int>& nBinsExs, const std::vector<float>& iBinMins );
+
+void SetBootErrors( PtAlgo& algo, TH1D* hist, const std::vector< std::vector<double> >& vals, const double norm );
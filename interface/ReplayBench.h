@@ -0,0 +1,149 @@
+#ifndef EMTFPtAssign2017_ReplayBench_h
+#define EMTFPtAssign2017_ReplayBench_h
+
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#include "TString.h"
+
+#include "../interface/PtAssigner.h"   // Per-track part of the chain
+#include "../interface/TrackBuilder.h" // Track-building cuts
+
+class NTupleGenerator;
+class PtClient;
+
+// Per-event latency histogram with log-linear bins: 2^SUB_BITS bins per power of two of the latency
+// in ns (below 3% relative width), exact below 2^SUB_BITS ns.  Filling is a count-leading-zeros and an
+// increment, so it can sit inside the timed loop; percentiles are read back to the bin centre.
+
+class LatencyHist {
+
+ public:
+
+  static const int SUB_BITS = 5;
+  static const int N_BINS   = (64 - SUB_BITS + 1) << SUB_BITS;
+
+  // Default constructor
+  LatencyHist() {
+    counts.assign( N_BINS, 0 );
+    n = 0; sum = 0; max = 0;
+  } // End default constructor LatencyHist()
+
+  static int Bin( const uint64_t ns ) {
+    if (ns < (uint64_t(1) << SUB_BITS)) return int(ns);
+    const int e = 63 - __builtin_clzll(ns);
+    return ((e - SUB_BITS + 1) << SUB_BITS) + int( (ns >> (e - SUB_BITS)) - (uint64_t(1) << SUB_BITS) );
+  }
+  static uint64_t BinLow  ( const int bin );
+  static uint64_t BinWidth( const int bin );
+
+  void Fill( const uint64_t ns ) {
+    counts[Bin(ns)] += 1;
+    n   += 1;
+    sum += ns;
+    if (ns > max) max = ns;
+  }
+
+  void Add( const LatencyHist& other );
+  void Reset();
+
+  // Latency (ns) below which a fraction q of the events lie, e.g. q = 0.99 for p99
+  double Percentile( const double q ) const;
+  double Mean() const { return (n > 0 ? double(sum) / n : 0.); }
+
+  std::vector<uint64_t> counts;
+  uint64_t n, sum, max;
+
+}; // End class LatencyHist
+
+
+// End-to-end replay of the L1 pT assignment chain used by the drivers:
+// hit collection by sector and station --> BuildTracksAllModes --> CalcTrackTheta, CalcDeltaPhis,
+// CalcDeltaThetas, FR bits, CalcBends, CalcRPCs (BIT_COMP) --> pT of every track, from the per-mode
+// LUT files of WritePtLut or the FixedPointBDT forests, loaded into assigner (one PtAssigner batch per event).
+// The hits of all events are first copied into memory, from ntuple files or NTupleGenerator, so neither
+// ROOT I/O nor generation is timed.  Run() replays the events n_pass times after one warm-up pass, and
+// records the latency of every event in LatencyHists: all events, by mode of the best track (highest
+// mode, 0 if none), and by hit multiplicity.  Summary() prints one line of key=value pairs with the
+// settings, throughput, percentiles and a checksum of all pT words, so runs of different commits on the
+// same events can be compared directly (a changed checksum means the chain output changed, too).
+
+class ReplayBench {
+
+ public:
+
+  static const int N_MULT = 7;  // Hit multiplicity bins: 0, 1, 2-3, 4-7, 8-15, 16-31, >= 32
+
+  // One hit of the "hit" branch, only the fields used by the chain
+  struct Hit {
+    int endcap, sector_index, station, ring, chamber;
+    int phi_int, theta_int, pattern, isRPC;
+  };
+
+  // Default constructor: track-building cuts of the training (GetAllModeCuts, TRK_MAX_DPH / TRK_MAX_DTH)
+  ReplayBench() {
+    GetAllModeCuts( min_CSC, max_RPC );
+    max_dPh   = TRK_MAX_DPH;
+    max_dTh   = TRK_MAX_DTH;
+    seconds   = 0;
+    n_evt_run = 0;
+    n_trk     = 0;
+    checksum  = 0;
+    client    = 0;
+    evt_first.push_back( 0 );
+  } // End default constructor ReplayBench()
+
+  // Append events to the replay sample; return the number of events added
+  Long64_t LoadNTuples( const std::vector<TString>& file_names, const Long64_t max_evt );
+  Long64_t LoadSynthetic( NTupleGenerator& gen, const Long64_t n_evt, const bool zero_bias, const ULong64_t seed );
+
+  // Replay all events n_pass times, after one untimed warm-up pass
+  void Run( const int n_pass );
+
+  void Print() const;
+  // One line of key=value pairs; also appended to file_name, if given
+  void Summary( const TString label, const TString file_name = "" ) const;
+
+  Long64_t NEvents() const { return Long64_t(evt_first.size()) - 1; }
+
+  static int MultBin( const int nHits );
+  static TString MultLabel( const int iMult );
+
+  std::array<int, 16> min_CSC;  // Minimum # of CSC LCTs by mode, -1 to skip the mode
+  std::array<int, 16> max_RPC;  // Maximum # of RPC hits by mode
+  int  max_dPh, max_dTh;
+  PtAssigner assigner;          // LUTs or BDTs of each mode (AddLut / AddBDT), and use_BDT
+  PtClient*  client;            // If set, the pT comes from a PtServer instead of assigner
+
+  TString source;               // Description of the events loaded, for Summary()
+  LatencyHist lat_all;
+  std::array<LatencyHist, 16>     lat_mode;
+  std::array<LatencyHist, N_MULT> lat_mult;
+  double   seconds;    // Wall time of the timed passes
+  Long64_t n_evt_run;  // Events replayed in the timed passes
+  Long64_t n_trk;      // Tracks assigned a pT in the timed passes
+  uint64_t checksum;   // Hash of the pT words of one pass, in event order
+
+ private:
+
+  ReplayBench( const ReplayBench& );
+  ReplayBench& operator=( const ReplayBench& );
+
+  // Full chain for one event; returns the mode of the best track, 0 if none.
+  // Tracks of modes without a LUT (or BDT) are built but get no pT.
+  int ProcessEvent( const Long64_t iEvt, uint64_t& hash, Long64_t& nTrk );
+
+  std::vector<Hit>      hits;
+  std::vector<Long64_t> evt_first;  // Hits of event i are [evt_first[i], evt_first[i+1])
+
+  // Working arrays of ProcessEvent(), kept between events so their capacity is reused
+  std::array< std::array< std::vector<int>, 4>, 12> id, ph, th, dt;
+  std::array< std::vector< std::array<int, 4> >, 16> trks_hits;
+  std::array< std::vector< std::array<int, 5> >, 16> trks_modes;
+  std::vector<PtAssignTrack>  batch;
+  std::vector<PtAssignResult> results;
+
+}; // End class ReplayBench
+
+#endif
@@ -1,18 +1,48 @@
+#ifndef EMTFPtAssign2017_TrackBuilder_h
+#define EMTFPtAssign2017_TrackBuilder_h
+
+#include <vector>
+#include <array>
+
+// Track-building limits and cuts of each mode used to train the BDTs (configs/PtRegression_Apr_2017), shared with ReplayBench
+const int TRK_MAX_DPH = 1024;  // Maximum dPhi between hits for track-building (excludes maximum)
+const int TRK_MAX_DTH = 8;     // Maximum dTheta between hits for track-building (includes maximum)
+
+// Minimum # of CSC LCTs and maximum # of RPC hits of one mode; unchanged for modes with fewer than 2 stations
+void GetModeCuts( const int mode, int& minCSC, int& maxRPC );
+// Cuts of all 11 multi-station modes, by mode; -1 for the others (BuildTracksAllModes skips them)
+void GetAllModeCuts( std::array<int, 16>& minCSC, std::array<int, 16>& maxRPC );
 
 void BuildTracks( std::vector< std::array<int, 4> >& trks_hits,  // Vector of tracks, with hit indices by station
 		  std::vector< std::array<int, 5> >& trks_modes, // Mode, CSC mode, RPC mode, and sumAbsDPhi/Theta of tracks
-		  const std::array< std::array< std::array<int, 4>, 4>, 12> id, // All hit index values, by sector and station
-                  const std::array< std::array< std::array<int, 4>, 4>, 12> ph, // All full-precision integer phi values
-                  const std::array< std::array< std::array<int, 4>, 4>, 12> th, // All full-precision integer theta values
-                  const std::array< std::array< std::array<int, 4>, 4>, 12> dt, // All detector values (0 for none, 1 for CSC, 2 for RPC)
+		  const std::array< std::array< std::vector<int>, 4>, 12> id, // All hit index values, by sector and station
+                  const std::array< std::array< std::vector<int>, 4>, 12> ph, // All full-precision integer phi values
+                  const std::array< std::array< std::vector<int>, 4>, 12> th, // All full-precision integer theta values
+                  const std::array< std::array< std::vector<int>, 4>, 12> dt, // All detector values (0 for none, 1 for CSC, 2 for RPC)
                   const int mode,            // Mode of track we're building
                   const int maxRPC = 0,      // Maximum # of stations with RPC hits
                   const int minCSC = 2,      // Minimum # of stations with CSC hits
-		  const int max_dPh=1024,    // Maximum dPhi between any two hits
-		  const int max_dTh=8        // Maximum dTheta between any two hits
+		  const int max_dPh=TRK_MAX_DPH,    // Maximum dPhi between any two hits
+		  const int max_dTh=TRK_MAX_DTH        // Maximum dTheta between any two hits
                   );
 
 
+// Build tracks of every mode in a single pass over each sector's hit combinations (each station: one hit or none).
+// Every candidate is classified by BuiltTrackMode, and kept in the list of its mode if it passes that mode's
+// minCSC / maxRPC cuts.  SelectTracks is then run separately for each mode.  Modes with minCSC < 0 are not built.
+void BuildTracksAllModes( std::array< std::vector< std::array<int, 4> >, 16>& trks_hits,  // Tracks of each mode, with hit indices by station
+			  std::array< std::vector< std::array<int, 5> >, 16>& trks_modes, // Mode, CSC mode, RPC mode, and sumAbsDPhi/Theta of tracks
+			  const std::array< std::array< std::vector<int>, 4>, 12> id, // All hit index values, by sector and station
+			  const std::array< std::array< std::vector<int>, 4>, 12> ph, // All full-precision integer phi values
+			  const std::array< std::array< std::vector<int>, 4>, 12> th, // All full-precision integer theta values
+			  const std::array< std::array< std::vector<int>, 4>, 12> dt, // All detector values (0 for none, 1 for CSC, 2 for RPC)
+			  const std::array<int, 16> maxRPC,  // Maximum # of stations with RPC hits, by mode
+			  const std::array<int, 16> minCSC,  // Minimum # of stations with CSC hits, by mode (-1 to skip the mode)
+			  const int max_dPh=TRK_MAX_DPH,    // Maximum dPhi between any two hits
+			  const int max_dTh=TRK_MAX_DTH        // Maximum dTheta between any two hits
+			  );
+
+
 void BuiltTrackMode( int& mode, int& mode_CSC, int& mode_RPC, 
 		     int& sumAbsDPh, int& sumAbsDTh,
 		     const std::array<int, 4> phs, // Full-precision integer phi by station
@@ -20,10 +50,12 @@ void BuiltTrackMode( int& mode, int& mode_CSC, int& mode_RPC,
 		     const std::array<int, 4> dts, // Detector by station (0 for none, 1 for CSC, 2 for RPC)
 		     const int maxRPC=0,         // Maximum # of stations with RPC hits
 		     const int minCSC=2,         // Minimum # of stations with CSC hits
-		     const int max_dPh=1024,     // Maximum dPhi between any two hits
-		     const int max_dTh=8         // Maximum dTheta between any two hits
+		     const int max_dPh=TRK_MAX_DPH,     // Maximum dPhi between any two hits
+		     const int max_dTh=TRK_MAX_DTH         // Maximum dTheta between any two hits
 		     );
 
 void SelectTracks( std::vector< std::array<int, 4> >& s_trks_hits,  // Vector of tracks, with hit indices by station 
 		   std::vector< std::array<int, 5> >& s_trks_modes  // Mode, CSC mode, RPC mode, and sumAbsDPhi/Theta of tracks
 		   );
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef EMTFPtAssign2017_TreeWriter_h
+#define EMTFPtAssign2017_TreeWriter_h
+
+#include <vector>
+#include <deque>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "TString.h"
+
+class TTree;
+class TFile;
+
+// Output layer for the TrainTree / TestTree copies at the end of PtRegression_Apr_2017.
+// Trees handed to Write() (filled in memory, detached from any file) are compressed on a background
+// thread into a temporary file, with the chosen algorithm, level and basket size and without the
+// dropped branches, while the main thread trains the next factory.  TMVA writes into the output
+// file during training, so the thread never touches it: Finish() copies the compressed baskets of
+// the temporary file into the output file as they are (no recompression), in the same directories.
+// Without async, Write() compresses in the calling thread, with the same settings and output.
+
+class AsyncTreeWriter {
+
+ public:
+
+  // algorithm: ROOT compression algorithm (1 ZLIB, 2 LZMA, 4 LZ4, 5 ZSTD with ROOT >= 6.20), level 0-9.
+  // drop_branches: branch names or wildcards, as in TTree::SetBranchStatus()
+  AsyncTreeWriter( const TString _tmp_file_name, const int _algorithm = 1, const int _level = 1,
+		   const int _basket_size = 32000, const std::vector<TString>& _drop_branches = std::vector<TString>(),
+		   const bool _async = true );
+  ~AsyncTreeWriter();
+
+  // Write tree as dir_name/<tree name>; takes ownership of the tree, and detaches it from its directory
+  void Write( TTree* tree, const TString dir_name );
+
+  // Wait for the queued trees, copy them into out_file, and remove the temporary file; false if a tree was lost
+  bool Finish( TFile* out_file );
+
+  // Bytes and time spent, from Finish()
+  void Print() const;
+
+  TString tmp_file_name;
+  int algorithm;
+  int level;
+  int basket_size;
+  std::vector<TString> drop_branches;
+  bool async;
+
+  int      n_trees;
+  Long64_t bytes_in;     // Uncompressed bytes of the written branches
+  Long64_t bytes_out;    // Compressed bytes written
+  double   write_sec;    // Compressing and writing the trees (on the background thread, if async)
+  double   wait_sec;     // Main thread waiting for the queue in Finish()
+  double   copy_sec;     // Copying the baskets into the output file
+
+ private:
+
+  AsyncTreeWriter( const AsyncTreeWriter& );
+  AsyncTreeWriter& operator=( const AsyncTreeWriter& );
+
+  void Run();                                            // Body of the writer thread
+  void WriteTree( TTree* tree, const TString dir_name );  // Compress one tree into the temporary file
+
+  TFile* file;  // Temporary file, only used by the writer thread (or the caller, without async)
+  bool ok;
+  bool stop;
+  std::vector< std::pair<TString, TString> > written;  // Directory and name of each tree in the temporary file
+  std::deque< std::pair<TTree*, TString> > queue;
+  std::thread thread;
+  std::mutex mtx;
+  std::condition_variable cv;
+
+}; // End class AsyncTreeWriter
+
+#endif
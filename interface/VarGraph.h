@@ -0,0 +1,76 @@
+#ifndef EMTFPtAssign2017_VarGraph_h
+#define EMTFPtAssign2017_VarGraph_h
+
+#include <vector>
+
+#include "TString.h"
+
+// Demand-driven computation of the built-track variables in PtRegression_Apr_2017.  Each variable a
+// factory can use is declared with the computation (node) it comes from, and each node with the nodes
+// it takes as input, e.g. CalcBends needs dPhSign from CalcDeltaPhis, CalcRPCs the track theta.
+// Require() the variables of every factory, and the nodes used outside the factories, once per job:
+// Resolve() adds the inputs, the track loop only runs the nodes with Needs(), and fills the variables
+// by their Var id instead of comparing names.
+
+class VarGraph {
+
+ public:
+
+  // Per-track computations and hit reads
+  enum Node { kHitRing1 = 0,        // st1_ring2, ring of the station 1 hit
+	      kCalcTheta,           // CalcTrackTheta()
+	      kCalcDeltaPhis,       // CalcDeltaPhis(): dPhi, dPhSign
+	      kCalcDeltaPhiSums,    // dPhi sums and outStPh, filled by CalcDeltaPhis() for mode 15
+	      kCalcDeltaThetas,     // CalcDeltaThetas()
+	      kCalcFRs,             // Front / rear from the chamber numbers
+	      kCalcBends,           // CalcBends(), from the hit patterns
+	      kCalcRPCs,            // CalcRPCs(), from the hit detectors
+	      kHitEtaPhi,           // eta and phi of the track
+	      kSharedMode,          // Stations shared with the EMTF track
+	      kNoNode };            // Muon and EMTF values, always available
+
+  // Variables filled in the factories, by name in Id()
+  enum Var { kUnknown = -1,
+	     kTheta, kSt1Ring2,
+	     kDPhi12, kDPhi13, kDPhi14, kDPhi23, kDPhi24, kDPhi34,
+	     kFR1, kFR2, kFR3, kFR4,
+	     kBend1, kBend2, kBend3, kBend4,
+	     kDPhiSum4, kDPhiSum4A, kDPhiSum3, kDPhiSum3A, kOutStPhi,
+	     kDTh12, kDTh13, kDTh14, kDTh23, kDTh24, kDTh34,
+	     kRPC1, kRPC2, kRPC3, kRPC4,
+	     kGenPtTrg, kInvGenPtTrg, kLog2GenPtTrg, kSqrtGenPtTrg, kGenChargeTrg,
+	     kGenPt, kEmtfPt, kInvGenPt, kInvEmtfPt, kLog2GenPt, kLog2EmtfPt,
+	     kGenEta, kEmtfEta, kTrkEta, kGenPhi, kEmtfPhi, kTrkPhi, kGenCharge, kEmtfCharge,
+	     kEmtfMode, kEmtfModeCSC, kEmtfModeRPC, kTrkMode, kTrkModeCSC, kTrkModeRPC,
+	     kShrdMode, kShrdModeCSC, kShrdModeRPC,
+	     kDPhiSign, kNTrk, kEvtWeight };
+
+  // Default constructor
+  VarGraph() {
+    required.assign( kNoNode, false );
+    needed  .assign( kNoNode, false );
+  } // End default constructor VarGraph()
+
+  // Id of a variable name, kUnknown if the track loop does not fill it (the default value is kept)
+  static Var Id( const TString name );
+  static Node NodeOf( const Var var );
+
+  // Require the nodes of these variables; returns their ids
+  std::vector<int> Require( const std::vector<TString>& names );
+  void Require( const Node node ) { required.at(node) = true; }
+
+  // Needed nodes: the required ones and all their inputs
+  void Resolve();
+  bool Needs( const Node node ) const { return needed.at(node); }
+
+  // Nodes computed and skipped per track
+  void Print() const;
+
+ private:
+
+  std::vector<bool> required;
+  std::vector<bool> needed;
+
+}; // End class VarGraph
+
+#endif
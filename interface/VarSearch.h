@@ -0,0 +1,85 @@
+#ifndef EMTFPtAssign2017_VarSearch_h
+#define EMTFPtAssign2017_VarSearch_h
+
+#include <vector>
+
+#include "TString.h"
+
+// Search over the in_vars hex masks of one factory with short proxy models, in place of one full
+// TMVA training per hand-edited mask.  A subsample of tracks is kept in memory with every variable
+// of the pool; each variable is binned once at its quantiles, and a candidate mask is scored by a
+// small least-squares gradient-boosted tree ensemble trained on the binned inputs, with the loss on
+// a held-out quarter of the events (chosen by a hash of the event number) as the score.
+// Search() is a beam search from the factory's mask: at each step every mask in the beam has one
+// variable of the pool added (forward) or removed (backward), the candidates are trained in parallel,
+// and the best beam_width masks are kept (beam_width = 1 is the plain greedy search).  A candidate
+// whose validation loss after PRUNE_AFTER trees is already worse than that of every mask in the beam
+// at the same point is dropped without finishing its training.  The search stops when a step improves
+// the best loss by less than MIN_GAIN.
+
+class VarSearch {
+
+ public:
+
+  static const int    N_BINS      = 64;   // Quantile bins per variable
+  static const int    N_TREES     = 40;   // Trees per proxy model
+  static const int    DEPTH       = 3;    // Depth of each tree
+  static const double SHRINKAGE;          // Learning rate, as the BDTG "Shrinkage" option
+  static const int    PRUNE_AFTER = 10;   // Trees trained before a candidate can be pruned
+  static const double PRUNE_TOL;          // Margin on the worst beam loss before pruning
+  static const double MIN_GAIN;           // Relative loss improvement needed to take another step
+
+  struct Result {
+    UInt_t mask;
+    int    n_vars;
+    double loss;       // Validation loss after the last tree trained
+    double loss_prune; // Validation loss after PRUNE_AFTER trees
+    int    n_trees;    // Trees trained: less than N_TREES if pruned
+    double seconds;    // Training time of the proxy model
+    bool   pruned;
+  };
+
+  // var_names: pool input variables, then the target; bits: bit of each input in the factory mask
+  VarSearch( const TString _name, const std::vector<TString>& _var_names, const std::vector<int>& _bits,
+	     const int _n_threads = 8 ) {
+    name      = _name;
+    bits      = _bits;
+    var_names = std::vector<TString>( _var_names.begin(), _var_names.begin() + bits.size() + 1 );
+    n_threads = _n_threads;
+  } // End constructor VarSearch()
+
+  // Same values and weight as passed to DataLoader::AddTrainingEvent()
+  void AddEvent( const ULong64_t event_id, const std::vector<Double_t>& var_vals, const Double_t weight );
+
+  // Ranked table of every mask trained, best first (pruned masks last)
+  std::vector<Result> Search( const UInt_t start_mask, const int beam_width, const int max_steps,
+			      const bool forward, const bool backward );
+
+  // Proxy model for one mask; stops after PRUNE_AFTER trees if the loss is above prune_loss
+  Result Evaluate( const UInt_t mask, const double prune_loss = -1 ) const;
+
+  void Print( const std::vector<Result>& results, const UInt_t start_mask ) const;
+
+  Long64_t NEvents() const { return weights.size(); }
+
+  TString name;
+  std::vector<TString> var_names;
+  std::vector<int> bits;
+  int n_threads;
+
+ private:
+
+  void BinInputs();
+
+  std::vector<Float_t> values;   // NEvents() x var_names.size()
+  std::vector<Float_t> weights;
+  std::vector<bool>    valid;    // Event in the validation sample
+
+  // Filled by BinInputs()
+  std::vector<UChar_t> bins;     // bits.size() x NEvents(), column by column
+  std::vector<Float_t> target;
+  std::vector<Long64_t> i_train, i_valid;
+
+}; // End class VarSearch
+
+#endif
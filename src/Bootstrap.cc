@@ -0,0 +1,110 @@
+
+#include "../interface/Bootstrap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+
+void PoissonBootstrap::Weights( const ULong64_t event_id, std::vector<UChar_t>& weights ) const {
+
+  // Cumulative Poisson(1) probabilities for 0 - 7; the rest (< 1e-5) is given weight 8
+  static const double CDF[8] = { 0.367879, 0.735759, 0.919699, 0.981012,
+				 0.996340, 0.999406, 0.999917, 0.999990 };
+
+  weights.resize( n_rep );
+  ULong64_t state = seed ^ (event_id * 0x9E3779B97F4A7C15ULL);
+  for (int iRep = 0; iRep < n_rep; iRep++) {
+    // splitmix64
+    ULong64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z =  z ^ (z >> 31);
+    const double u = (z >> 11) * (1.0 / 9007199254740992.0);  // Uniform in [0, 1)
+
+    int w = 0;
+    while (w < 8 && u >= CDF[w]) w++;
+    weights.at(iRep) = w;
+  }
+
+} // End function: void PoissonBootstrap::Weights()
+
+
+BootHist2D::BootHist2D( const int _n_rep, const int _nx, const double _xmin, const double _xmax,
+			const int _ny, const double _ymin, const double _ymax ) {
+
+  n_rep = _n_rep;
+  nx = _nx;  xmin = _xmin;  xmax = _xmax;
+  ny = _ny;  ymin = _ymin;  ymax = _ymax;
+  counts.assign( size_t(n_rep) * (nx + 2) * (ny + 2), 0 );
+  cumulated = false;
+
+} // End constructor BootHist2D()
+
+
+int BootHist2D::Bin( const double v, const int n, const double vmin, const double vmax ) const {
+
+  if (v <  vmin) return 0;
+  if (v >= vmax) return n + 1;
+  return 1 + int( n * (v - vmin) / (vmax - vmin) );
+
+} // End function: int BootHist2D::Bin()
+
+
+void BootHist2D::Fill( const double x, const double y, const std::vector<UChar_t>& weights ) {
+
+  assert( !cumulated && int(weights.size()) == n_rep );
+  const size_t bin    = size_t( Bin(x, nx, xmin, xmax) ) * (ny + 2) + Bin(y, ny, ymin, ymax);
+  const size_t stride = size_t(nx + 2) * (ny + 2);
+  for (int iRep = 0; iRep < n_rep; iRep++)
+    counts[iRep * stride + bin] += weights[iRep];
+
+} // End function: void BootHist2D::Fill()
+
+
+void BootHist2D::Cumulate() {
+
+  for (int iRep = 0; iRep < n_rep; iRep++) {
+    for (int ix = 0; ix < nx + 2; ix++) {
+      UInt_t* col = &counts[ (size_t(iRep) * (nx + 2) + ix) * (ny + 2) ];
+      for (int iy = ny - 1; iy >= 0; iy--)  // Overflow bin ny + 1 is left out, as in Integral(..., iy1, ny)
+	col[iy] += col[iy + 1];
+    }
+  }
+  cumulated = true;
+
+} // End function: void BootHist2D::Cumulate()
+
+
+double BootHist2D::Integral( const int iRep, int ix1, int ix2, int iy1 ) const {
+
+  assert( cumulated );
+  ix1 = std::max( ix1, 0 );
+  ix2 = std::min( ix2, nx + 1 );
+  iy1 = std::max( iy1, 0 );
+  if (iy1 > ny) return 0;
+
+  double sum = 0;
+  for (int ix = ix1; ix <= ix2; ix++)
+    sum += counts[ (size_t(iRep) * (nx + 2) + ix) * (ny + 2) + iy1 ];
+  return sum;
+
+} // End function: double BootHist2D::Integral()
+
+
+void BootBand( std::vector<double> vals, double& lo, double& hi, double& rms ) {
+
+  lo = hi = rms = 0;
+  const int n = vals.size();
+  if (n == 0) return;
+
+  double mean = 0;
+  for (int i = 0; i < n; i++) mean += vals[i] / n;
+  for (int i = 0; i < n; i++) rms += pow(vals[i] - mean, 2) / n;
+  rms = sqrt(rms);
+
+  std::sort( vals.begin(), vals.end() );
+  lo = vals.at( int( floor(0.16 * (n - 1) + 0.5) ) );
+  hi = vals.at( int( floor(0.84 * (n - 1) + 0.5) ) );
+
+} // End function: void BootBand()
@@ -0,0 +1,76 @@
+
+#include "../interface/DenseHist.h"
+
+#include "TH1.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+
+DenseHist::DenseHist( const int _n_hist, const int _nx, const double _xmin, const double _xmax,
+		      const int _ny, const double _ymin, const double _ymax ) {
+
+  n_hist = _n_hist;
+  nx = _nx;  xmin = _xmin;  xmax = _xmax;
+  ny = _ny;  ymin = _ymin;  ymax = _ymax;
+  n_cells = (nx + 2) * (ny > 0 ? ny + 2 : 1);
+
+  sumw   .assign( n_hist * n_cells, 0 );
+  sumw2  .assign( n_hist * n_cells, 0 );
+  entries.assign( n_hist, 0 );
+
+} // End constructor DenseHist()
+
+
+double DenseHist::Integral( const int iHist ) const {
+
+  double sum = 0;
+  for (int iy = (ny > 0 ? 1 : 0); iy <= ny; iy++)
+    for (int ix = 1; ix <= nx; ix++)
+      sum += Content( iHist, ix, iy );
+  return sum;
+
+} // End function: double DenseHist::Integral()
+
+
+void DenseHist::Add( const DenseHist& other ) {
+
+  assert( other.n_hist == n_hist && other.n_cells == n_cells && other.nx == nx && other.ny == ny );
+  for (size_t i = 0; i < sumw.size(); i++) {
+    sumw [i] += other.sumw [i];
+    sumw2[i] += other.sumw2[i];
+  }
+  for (int iHist = 0; iHist < n_hist; iHist++)
+    entries[iHist] += other.entries[iHist];
+
+} // End function: void DenseHist::Add()
+
+
+void DenseHist::Reset() {
+
+  std::fill( sumw   .begin(), sumw   .end(), 0 );
+  std::fill( sumw2  .begin(), sumw2  .end(), 0 );
+  std::fill( entries.begin(), entries.end(), 0 );
+
+} // End function: void DenseHist::Reset()
+
+
+bool DenseHist::CopyTo( const int iHist, TH1* hist ) const {
+
+  if ( hist->GetNcells() != n_cells || hist->GetNbinsX() != nx || (ny > 0 && hist->GetNbinsY() != ny) ) {
+    std::cout << "ERROR: DenseHist binning does not match " << hist->GetName() << std::endl;
+    return false;
+  }
+
+  if (hist->GetSumw2N() == 0) hist->Sumw2();
+  const int first = Index(iHist);
+  for (int bin = 0; bin < n_cells; bin++) {  // ROOT global bin numbers
+    hist->SetBinContent( bin, sumw[first + bin] );
+    hist->SetBinError  ( bin, sqrt( sumw2[first + bin] ) );
+  }
+  hist->SetEntries( entries[iHist] );
+  return true;
+
+} // End function: bool DenseHist::CopyTo()
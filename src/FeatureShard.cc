@@ -0,0 +1,316 @@
+
+#include "../interface/FeatureShard.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+#include <cassert>
+#include <algorithm>
+
+const size_t FEATURE_SHARD_BUFFER = 1 << 20;  // stdio buffer of the feature files
+
+
+bool FeatureShardWriter::Open( const TString _file_name, const int shard_index, const int shard_count, const bool global_ordinals,
+			       const std::vector<TString>& fact_names, const std::vector<int>& _n_vals ) {
+
+  assert( fact_names.size() == _n_vals.size() && fact_names.size() < (1 << 16) );
+  file_name = _file_name;
+  n_vals    = _n_vals;
+
+  memset( &header, 0, sizeof(header) );
+  memcpy( header.magic, FEATURE_SHARD_MAGIC, sizeof(FEATURE_SHARD_MAGIC) );
+  header.version         = FEATURE_SHARD_VERSION;
+  header.shard_index     = shard_index;
+  header.shard_count     = shard_count;
+  header.global_ordinals = global_ordinals;
+  header.n_fact          = fact_names.size();
+
+  file = fopen( (file_name + ".tmp").Data(), "wb" );
+  if (file == 0) {
+    std::cout << "ERROR: could not create feature file " << file_name << ".tmp" << std::endl;
+    return false;
+  }
+  setvbuf( file, 0, _IOFBF, FEATURE_SHARD_BUFFER );
+
+  bool ok = ( fwrite( &header, sizeof(header), 1, file ) == 1 );
+  for (UInt_t i = 0; i < fact_names.size(); i++) {
+    const uint32_t len = fact_names.at(i).Length();
+    const uint32_t n   = n_vals.at(i);
+    ok = ok && fwrite( &len, sizeof(len), 1, file ) == 1;
+    ok = ok && fwrite( fact_names.at(i).Data(), 1, len, file ) == len;
+    ok = ok && fwrite( &n, sizeof(n), 1, file ) == 1;
+  }
+  if (!ok) {
+    std::cout << "ERROR: could not write feature file " << file_name << ".tmp" << std::endl;
+    fclose( file );
+    file = 0;
+  }
+  return ok;
+
+} // End function: bool FeatureShardWriter::Open()
+
+
+void FeatureShardWriter::AddRow( const uint32_t iEvt, const bool isMC, const bool trainEvt, const int iFact,
+				 const std::vector<Double_t>& vals, const double weight ) {
+
+  assert( file != 0 && iFact >= 0 && iFact < int(n_vals.size()) && int(vals.size()) == n_vals.at(iFact) );
+  uint8_t  flags[2] = { uint8_t(isMC), uint8_t(trainEvt) };
+  uint16_t fact     = iFact;
+  buf.assign( 1, weight );
+  buf.insert( buf.end(), vals.begin(), vals.end() );
+
+  fwrite( &iEvt, sizeof(iEvt), 1, file );
+  fwrite( flags, 1, 2, file );
+  fwrite( &fact, sizeof(fact), 1, file );
+  fwrite( buf.data(), sizeof(double), buf.size(), file );
+  header.n_rows += 1;
+
+} // End function: void FeatureShardWriter::AddRow()
+
+
+bool FeatureShardWriter::Close( const uint64_t n_MC, const uint64_t n_ZB ) {
+
+  if (file == 0) return false;
+  header.n_MC = n_MC;
+  header.n_ZB = n_ZB;
+
+  // Final counts go into the header, written first with zeros
+  bool ok = ( ferror(file) == 0 && fseek( file, 0, SEEK_SET ) == 0 &&
+	      fwrite( &header, sizeof(header), 1, file ) == 1 );
+  ok = ( fclose(file) == 0 ) && ok;
+  file = 0;
+  if ( ok && rename( (file_name + ".tmp").Data(), file_name.Data() ) == 0 ) {
+    std::cout << "Wrote " << header.n_rows << " feature rows of " << n_MC << " MC and " << n_ZB
+	      << " ZeroBias events to " << file_name << std::endl;
+    return true;
+  }
+  std::cout << "ERROR: could not write feature file " << file_name << std::endl;
+  return false;
+
+} // End function: bool FeatureShardWriter::Close()
+
+
+bool FeatureShardWriter::Flush( uint64_t& bytes ) {
+
+  if (file == 0 || fflush( file ) != 0 || ferror( file ) != 0) {
+    std::cout << "ERROR: could not write feature file " << file_name << ".tmp" << std::endl;
+    return false;
+  }
+  bytes = ftello( file );
+  return true;
+
+} // End function: bool FeatureShardWriter::Flush()
+
+
+bool FeatureShardWriter::Resume( const TString _file_name, const int shard_index, const int shard_count, const bool global_ordinals,
+				 const std::vector<TString>& fact_names, const std::vector<int>& _n_vals,
+				 const uint64_t n_rows, const uint64_t bytes ) {
+
+  // The header of an unfinished file holds the Open() arguments, with zero counts
+  FeatureShardReader prev;
+  if ( !prev.Open( _file_name + ".tmp" ) ) return false;
+  if ( !prev.SameFactories( fact_names, _n_vals ) || int(prev.header.shard_index) != shard_index ||
+       int(prev.header.shard_count) != shard_count || bool(prev.header.global_ordinals) != global_ordinals ) {
+    std::cout << "ERROR: " << _file_name << ".tmp was written with other arguments, not resuming it" << std::endl;
+    return false;
+  }
+  header = prev.header;
+  prev.Close();
+
+  // Rows written after the checkpoint are dropped, and read again
+  file_name = _file_name;
+  n_vals    = _n_vals;
+  file = fopen( (file_name + ".tmp").Data(), "r+b" );
+  if ( file == 0 || fseeko( file, 0, SEEK_END ) != 0 || uint64_t(ftello( file )) < bytes ||
+       ftruncate( fileno( file ), bytes ) != 0 || fseeko( file, bytes, SEEK_SET ) != 0 ) {
+    std::cout << "ERROR: could not resume feature file " << file_name << ".tmp at " << bytes << " bytes" << std::endl;
+    if (file) fclose( file );
+    file = 0;
+    return false;
+  }
+  setvbuf( file, 0, _IOFBF, FEATURE_SHARD_BUFFER );
+  header.n_rows = n_rows;
+  std::cout << "Resuming feature file " << file_name << " after " << n_rows << " rows" << std::endl;
+  return true;
+
+} // End function: bool FeatureShardWriter::Resume()
+
+
+bool FeatureShardReader::Open( const TString _file_name ) {
+
+  Close();
+  file_name = _file_name;
+  fact_names.clear();
+  n_vals.clear();
+  n_read = 0;
+
+  file = fopen( file_name.Data(), "rb" );
+  if (file == 0) {
+    std::cout << "ERROR: could not open feature file " << file_name << std::endl;
+    return false;
+  }
+  setvbuf( file, 0, _IOFBF, FEATURE_SHARD_BUFFER );
+
+  bool ok = ( fread( &header, sizeof(header), 1, file ) == 1 &&
+	      memcmp( header.magic, FEATURE_SHARD_MAGIC, sizeof(FEATURE_SHARD_MAGIC) ) == 0 &&
+	      header.version == FEATURE_SHARD_VERSION && header.shard_index < header.shard_count );
+  for (uint32_t i = 0; ok && i < header.n_fact; i++) {
+    uint32_t len = 0, n = 0;
+    ok = ( fread( &len, sizeof(len), 1, file ) == 1 && len < 4096 );
+    std::vector<char> name( len + 1, '\0' );
+    ok = ok && fread( name.data(), 1, len, file ) == len;
+    ok = ok && fread( &n, sizeof(n), 1, file ) == 1;
+    fact_names.push_back( name.data() );
+    n_vals.push_back( n );
+  }
+  if (!ok) {
+    std::cout << "ERROR: " << file_name << " is not a feature file of version " << FEATURE_SHARD_VERSION << std::endl;
+    Close();
+  }
+  return ok;
+
+} // End function: bool FeatureShardReader::Open()
+
+
+void FeatureShardReader::Close() {
+
+  if (file) fclose( file );
+  file = 0;
+
+} // End function: void FeatureShardReader::Close()
+
+
+bool FeatureShardReader::Next( FeatureRow& row ) {
+
+  if (file == 0 || n_read >= header.n_rows) return false;
+
+  uint8_t  flags[2];
+  uint16_t fact;
+  if ( fread( &row.iEvt, sizeof(row.iEvt), 1, file ) != 1 || fread( flags, 1, 2, file ) != 2 ||
+       fread( &fact, sizeof(fact), 1, file ) != 1 || fact >= n_vals.size() ) {
+    std::cout << "ERROR: " << file_name << " is truncated after " << n_read << " of " << header.n_rows << " rows" << std::endl;
+    return false;
+  }
+  row.isMC     = flags[0];
+  row.trainEvt = flags[1];
+  row.iFact    = fact;
+  row.vals.resize( n_vals.at(fact) );
+  if ( fread( &row.weight, sizeof(double), 1, file ) != 1 ||
+       fread( row.vals.data(), sizeof(double), row.vals.size(), file ) != row.vals.size() ) {
+    std::cout << "ERROR: " << file_name << " is truncated after " << n_read << " of " << header.n_rows << " rows" << std::endl;
+    return false;
+  }
+  n_read += 1;
+  return true;
+
+} // End function: bool FeatureShardReader::Next()
+
+
+bool FeatureShardReader::SameFactories( const std::vector<TString>& _fact_names, const std::vector<int>& _n_vals ) const {
+
+  return (fact_names == _fact_names && n_vals == _n_vals);
+
+} // End function: bool FeatureShardReader::SameFactories()
+
+
+// One "key value" line each
+bool FeatureCheckpoint::Write( const TString file_name ) const {
+
+  const TString tmp_name = file_name + ".tmp";
+  std::ofstream out( tmp_name.Data() );
+  out << "EMTFCKPT " << FEATURE_SHARD_VERSION << "\n" << "config " << config << "\n" << "entry " << entry << "\n"
+      << "iEvt " << iEvt << "\n" << "iEvtZB " << iEvtZB << "\n" << "n_rows " << n_rows << "\n" << "bytes " << bytes << "\n";
+  out.close();
+  if ( !out || std::rename( tmp_name.Data(), file_name.Data() ) != 0 ) {
+    std::cout << "ERROR: could not write checkpoint " << file_name << std::endl;
+    std::remove( tmp_name.Data() );
+    return false;
+  }
+  return true;
+
+} // End function: bool FeatureCheckpoint::Write()
+
+
+bool FeatureCheckpoint::Read( const TString file_name ) {
+
+  std::ifstream in( file_name.Data() );
+  std::string tag, key;
+  uint32_t version = 0;
+  if ( !(in >> tag >> version) || tag != "EMTFCKPT" || version != FEATURE_SHARD_VERSION ) return false;
+  bool ok = ( in >> key >> config  ) && key == "config";
+  ok = ok && ( in >> key >> entry  ) && key == "entry";
+  ok = ok && ( in >> key >> iEvt   ) && key == "iEvt";
+  ok = ok && ( in >> key >> iEvtZB ) && key == "iEvtZB";
+  ok = ok && ( in >> key >> n_rows ) && key == "n_rows";
+  ok = ok && ( in >> key >> bytes  ) && key == "bytes";
+  return ok;
+
+} // End function: bool FeatureCheckpoint::Read()
+
+
+uint64_t FeatureCheckpoint::Hash( const std::string& str ) {
+
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < str.size(); i++)
+    hash = (hash ^ uint64_t((unsigned char) str[i])) * 0x100000001b3ULL;
+  return hash;
+
+} // End function: uint64_t FeatureCheckpoint::Hash()
+
+
+bool MergeFeatureShards( const std::vector<TString>& in_files, const TString out_file ) {
+
+  // Order the shards by index, and check they are all the shards of one run
+  const int nIn = in_files.size();
+  std::vector<FeatureShardReader*> shards( nIn, (FeatureShardReader*) 0 );
+  bool ok = (nIn > 0);
+  for (int i = 0; i < nIn && ok; i++) {
+    FeatureShardReader* shard = new FeatureShardReader();
+    ok = shard->Open( in_files.at(i) );
+    if ( ok && (int(shard->header.shard_count) != nIn || shards.at(shard->header.shard_index) != 0) ) {
+      std::cout << "ERROR: " << in_files.at(i) << " is shard " << shard->header.shard_index << " of "
+		<< shard->header.shard_count << ", expected one of each of " << nIn << " shards" << std::endl;
+      ok = false;
+    }
+    if (ok) shards.at(shard->header.shard_index) = shard;
+    else    delete shard;
+  }
+  for (int i = 1; i < nIn && ok; i++) {
+    if ( !shards.at(i)->SameFactories( shards.at(0)->fact_names, shards.at(0)->n_vals ) ||
+	 shards.at(i)->header.global_ordinals != shards.at(0)->header.global_ordinals ) {
+      std::cout << "ERROR: " << shards.at(i)->file_name << " and " << shards.at(0)->file_name
+		<< " come from different configurations" << std::endl;
+      ok = false;
+    }
+  }
+
+  FeatureShardWriter out;
+  if (ok) {
+    const FeatureShardReader& first = *shards.at(0);
+    ok = out.Open( out_file, 0, 1, true, first.fact_names, first.n_vals );
+  }
+
+  // Shard i starts where shard i-1 stopped: without skim ordinals, its MC events follow those of the earlier shards
+  uint64_t offset = 0, n_MC = 0, n_ZB = 0;
+  FeatureRow row;
+  for (int i = 0; i < nIn && ok; i++) {
+    FeatureShardReader& shard = *shards.at(i);
+    const bool global = shard.header.global_ordinals;
+    while ( shard.Next( row ) )
+      out.AddRow( uint32_t(row.iEvt + (global ? 0 : offset)), row.isMC, row.trainEvt, row.iFact, row.vals, row.weight );
+    ok = shard.Complete();
+    if (global) n_MC = std::max( n_MC, uint64_t(shard.header.n_MC) );
+    else        n_MC = offset + shard.header.n_MC;
+    offset  = n_MC;
+    n_ZB   += shard.header.n_ZB;
+  }
+  if (ok) ok = out.Close( n_MC, n_ZB );
+
+  for (int i = 0; i < nIn; i++)
+    delete shards.at(i);
+  if (!ok) std::cout << "ERROR: could not merge the feature shards into " << out_file << std::endl;
+  return ok;
+
+} // End function: bool MergeFeatureShards()
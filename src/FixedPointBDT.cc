@@ -0,0 +1,223 @@
+
+#include "../interface/FixedPointBDT.h"
+#include "TXMLEngine.h"
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+
+// Recursively copy one <Node> of a TMVA <BinaryTree> into the flattened forest, returning its index
+static int AddBDTNode( FixedPointBDT& bdt, TXMLEngine& xml, XMLNodePointer_t node ) {
+
+  int iNode = bdt.node_var.size();
+  bdt.node_var     .push_back(-1);
+  bdt.node_cut_type.push_back( 1);
+  bdt.node_left    .push_back(-1);
+  bdt.node_right   .push_back(-1);
+  bdt.node_val     .push_back( 0);
+
+  XMLNodePointer_t left  = 0;
+  XMLNodePointer_t right = 0;
+  for (XMLNodePointer_t child = xml.GetChild(node); child != 0; child = xml.GetNext(child)) {
+    if ( strcmp(xml.GetNodeName(child), "Node") != 0 ) continue;
+    const char* pos = xml.GetAttr(child, "pos");
+    if      (pos && pos[0] == 'l') left  = child;
+    else if (pos && pos[0] == 'r') right = child;
+  }
+
+  if (left == 0 && right == 0) { // Leaf node: store the rounded regression response
+    double res = atof( xml.GetAttr(node, "res") );
+    bdt.node_val.at(iNode) = llround( ldexp(res, bdt.frac_bits) );
+    return iNode;
+  }
+  assert( left != 0 && right != 0 );
+
+  int iVar = atoi( xml.GetAttr(node, "IVar") );
+  assert( iVar >= 0 && iVar < bdt.NVars() );
+  if ( xml.HasAttr(node, "NCoef") && atoi( xml.GetAttr(node, "NCoef") ) != 0 ) {  // No NCoef in older TMVA weight files
+    std::cout << "\n\nERROR: FixedPointBDT does not support Fisher cuts (NCoef > 0)\n\n" << std::endl;
+    assert(false);
+  }
+
+  // TMVA compares the float input to a float cut; on integer inputs x >= cut <==> x >= ceil(cut)
+  float cut = atof( xml.GetAttr(node, "Cut") );
+  bdt.node_var     .at(iNode) = iVar;
+  bdt.node_cut_type.at(iNode) = ( atoi( xml.GetAttr(node, "cType") ) == 1 );
+  bdt.node_val     .at(iNode) = (int64_t) std::ceil( cut );
+
+  int iLeft  = AddBDTNode( bdt, xml, left );
+  int iRight = AddBDTNode( bdt, xml, right );
+  bdt.node_left .at(iNode) = iLeft;
+  bdt.node_right.at(iNode) = iRight;
+
+  return iNode;
+} // End function: static int AddBDTNode()
+
+
+bool FixedPointBDT::ReadWeightFile( const std::string file_name ) {
+
+  assert( frac_bits > 0 && frac_bits <= 30 );
+  assert( out_bits  > 0 && out_bits  <= 16 );
+  assert( lsb_shift >= 0 && lsb_shift < frac_bits );
+
+  var_names.clear();
+  tree_roots.clear();
+  node_var.clear();
+  node_cut_type.clear();
+  node_left.clear();
+  node_right.clear();
+  node_val.clear();
+  offset = 0;
+  targ_name = "";
+
+  TXMLEngine xml;
+  XMLDocPointer_t doc = xml.ParseFile( file_name.c_str() );
+  if (doc == 0) {
+    std::cout << "ERROR: could not parse BDT weight file " << file_name << std::endl;
+    return false;
+  }
+  XMLNodePointer_t top = xml.DocGetRootElement(doc);
+  if ( xml.HasAttr(top, "Method") )
+    method_name = xml.GetAttr(top, "Method");
+
+  bool found_weights = false;
+  for (XMLNodePointer_t node = xml.GetChild(top); node != 0; node = xml.GetNext(node)) {
+    std::string name = xml.GetNodeName(node);
+
+    if (name == "Variables") {
+      for (XMLNodePointer_t var = xml.GetChild(node); var != 0; var = xml.GetNext(var))
+	if ( strcmp(xml.GetNodeName(var), "Variable") == 0 )
+	  var_names.push_back( xml.GetAttr(var, "Expression") );
+    }
+
+    else if (name == "Targets") {
+      for (XMLNodePointer_t targ = xml.GetChild(node); targ != 0; targ = xml.GetNext(targ))
+	if ( strcmp(xml.GetNodeName(targ), "Target") == 0 && targ_name == "" )
+	  targ_name = xml.GetAttr(targ, "Expression");
+    }
+
+    else if (name == "Transformations") {
+      if ( atoi( xml.GetAttr(node, "NTransformations") ) != 0 ) {
+	std::cout << "ERROR: " << file_name << " uses input variable transformations, "
+		  << "which cannot be applied to the integer LUT inputs" << std::endl;
+	xml.FreeDoc(doc);
+	return false;
+      }
+    }
+
+    else if (name == "Weights") {
+      found_weights = true;
+      for (XMLNodePointer_t tree = xml.GetChild(node); tree != 0; tree = xml.GetNext(tree)) {
+	if ( strcmp(xml.GetNodeName(tree), "BinaryTree") != 0 ) continue;
+
+	// For gradient-boosted regression TMVA returns fBoostWeights[0] + sum of the tree responses
+	if ( tree_roots.size() == 0 )
+	  offset = llround( ldexp( atof( xml.GetAttr(tree, "boostWeight") ), frac_bits ) );
+
+	XMLNodePointer_t root = xml.GetChild(tree);
+	while ( root != 0 && strcmp(xml.GetNodeName(root), "Node") != 0 )
+	  root = xml.GetNext(root);
+	assert( root != 0 );
+	tree_roots.push_back( AddBDTNode( *this, xml, root ) );
+      }
+    }
+  } // End loop: for (XMLNodePointer_t node = xml.GetChild(top); node != 0; node = xml.GetNext(node))
+
+  xml.FreeDoc(doc);
+
+  if (!found_weights || tree_roots.size() == 0) {
+    std::cout << "ERROR: no BDT found in weight file " << file_name << std::endl;
+    return false;
+  }
+
+  // pT targets of PtRegression_Apr_2017.C, with or without the "_trg" suffix (pT capped at PTMAX_TRG)
+  std::string targ_base = targ_name;
+  if ( targ_base.size() > 4 && targ_base.compare( targ_base.size() - 4, 4, "_trg" ) == 0 )
+    targ_base.erase( targ_base.size() - 4 );
+  if      (targ_base == "inv_GEN_pt")  targ_type = kInvPt;
+  else if (targ_base == "log2_GEN_pt") targ_type = kLog2Pt;
+  else if (targ_base == "sqrt_GEN_pt") targ_type = kSqrtPt;
+  else if (targ_base == "GEN_pt")      targ_type = kPt;
+  else {
+    std::cout << "ERROR: target " << targ_name << " of " << file_name << " is not a pT regression target" << std::endl;
+    tree_roots.clear();  // NTrees() == 0: nothing is evaluated with this forest
+    return false;
+  }
+
+  std::cout << "Loaded " << method_name << " with " << NTrees() << " trees, " << NNodes() << " nodes, "
+	    << NVars() << " inputs and target " << targ_name << " from " << file_name << std::endl;
+  return true;
+} // End function: bool FixedPointBDT::ReadWeightFile()
+
+
+int FixedPointBDT::VarIndex( const std::string name ) const {
+  for (int i = 0; i < NVars(); i++)
+    if (var_names.at(i) == name)
+      return i;
+  return -1;
+} // End function: int FixedPointBDT::VarIndex()
+
+
+int64_t FixedPointBDT::EvalSum( const int* vars ) const {
+
+  const int*     var  = node_var.data();
+  const int*     type = node_cut_type.data();
+  const int*     left = node_left.data();
+  const int*     rght = node_right.data();
+  const int64_t* val  = node_val.data();
+
+  int64_t sum = offset;
+  for (int iTr = 0; iTr < NTrees(); iTr++) {
+    int n = tree_roots[iTr];
+    while (var[n] >= 0)
+      n = ( (vars[var[n]] >= val[n]) == type[n] ) ? rght[n] : left[n];
+    sum += val[n];
+  }
+  return sum;
+} // End function: int64_t FixedPointBDT::EvalSum()
+
+
+int FixedPointBDT::WordFromSum( const int64_t sum ) const {
+
+  const int64_t max_word = (int64_t(1) << out_bits) - 1;
+  int64_t word = max_word;
+
+  // 1/pT target: pT / LSB = 2^(FRAC_BITS + LSB_SHIFT) / sum, rounded, all in integers
+  if (targ_type == kInvPt) {
+    if (sum > 0) {
+      int64_t num = int64_t(1) << (frac_bits + lsb_shift);
+      word = (num + sum / 2) / sum;
+    }
+  }
+  // log2(pT) target: the only conversion needing a transcendental, evaluated on the exact integer sum
+  else if (targ_type == kLog2Pt) {
+    double log2_word = ldexp( double(sum), -frac_bits ) + lsb_shift;
+    if (log2_word < out_bits + 1)
+      word = llround( exp2(log2_word) );
+  }
+  // sqrt(pT) target: pT / LSB = sum^2 / 2^(2*FRAC_BITS - LSB_SHIFT)
+  else if (targ_type == kSqrtPt) {
+    uint64_t abs_sum = (sum < 0 ? -sum : sum);
+    if ( abs_sum < (uint64_t(1) << 31) ) {
+      int shift = 2*frac_bits - lsb_shift;
+      word = (abs_sum*abs_sum + (uint64_t(1) << (shift - 1))) >> shift;
+    }
+  }
+  // pT target: pT / LSB = sum / 2^(FRAC_BITS - LSB_SHIFT)
+  else {
+    int shift = frac_bits - lsb_shift;
+    word = (sum < 0 ? 0 : (sum + (int64_t(1) << (shift - 1))) >> shift);
+  }
+
+  if (word > max_word) word = max_word;
+  if (word < 0)        word = 0;
+  return int(word);
+} // End function: int FixedPointBDT::WordFromSum()
+
+
+int FixedPointBDT::EvalPtWord( const int* vars ) const {
+  return WordFromSum( EvalSum(vars) );
+} // End function: int FixedPointBDT::EvalPtWord()
@@ -0,0 +1,84 @@
+
+#include "../interface/HitIndex.h"
+
+#include "TBranch.h"
+#include "TLeaf.h"
+
+
+void HitIndex::Fill( TBranch* hit_br, const int nHits ) {
+
+  // One name lookup per leaf, instead of one per hit and muon
+  TLeaf* l_eta    = hit_br->GetLeaf("eta");
+  TLeaf* l_sector = hit_br->GetLeaf("sector_index");
+  TLeaf* l_st     = hit_br->GetLeaf("station");
+  TLeaf* l_phi    = hit_br->GetLeaf("phi_int");
+  TLeaf* l_theta  = hit_br->GetLeaf("theta_int");
+  TLeaf* l_RPC    = hit_br->GetLeaf("isRPC");
+
+  sector_index.resize( nHits );
+  station     .resize( nHits );
+  phi_int     .resize( nHits );
+  theta_int   .resize( nHits );
+  isRPC       .resize( nHits );
+  eta_pos     .resize( nHits );
+  prev        .resize( nHits );
+  last.clear();
+
+  for (int iHit = 0; iHit < nHits; iHit++) {
+    eta_pos     [iHit] = ( l_eta->GetValue(iHit) > 0 );
+    sector_index[iHit] = l_sector->GetValue(iHit);
+    station     [iHit] = l_st    ->GetValue(iHit);
+    phi_int     [iHit] = l_phi   ->GetValue(iHit);
+    theta_int   [iHit] = l_theta ->GetValue(iHit);
+    isRPC       [iHit] = ( l_RPC->GetValue(iHit) != 0 );
+
+    const uint64_t key = Key( sector_index[iHit], station[iHit], phi_int[iHit], theta_int[iHit], isRPC[iHit], eta_pos[iHit] );
+    std::unordered_map<uint64_t, int>::iterator it = last.find( key );
+    if (it == last.end()) {
+      prev[iHit] = -1;
+      last.insert( std::make_pair(key, iHit) );
+    } else {
+      prev[iHit] = it->second;
+      it->second = iHit;
+    }
+  }
+
+} // End function: void HitIndex::Fill()
+
+
+void HitIndex::FillTracks( TBranch* trk_br, const int nTrks ) {
+
+  TLeaf* l_sector = trk_br->GetLeaf("hit_sector_index");
+  TLeaf* l_phi    = trk_br->GetLeaf("hit_phi_int");
+  TLeaf* l_theta  = trk_br->GetLeaf("hit_theta_int");
+  TLeaf* l_RPC    = trk_br->GetLeaf("hit_isRPC");
+
+  const int nTrkHits = 4 * nTrks;
+  trk_sector_index.resize( nTrkHits );
+  trk_phi_int     .resize( nTrkHits );
+  trk_theta_int   .resize( nTrkHits );
+  trk_isRPC       .resize( nTrkHits );
+
+  for (int id = 0; id < nTrkHits; id++) {
+    trk_sector_index[id] = l_sector->GetValue(id);
+    trk_phi_int     [id] = l_phi   ->GetValue(id);
+    trk_theta_int   [id] = l_theta ->GetValue(id);
+    trk_isRPC       [id] = ( l_RPC->GetValue(id) == 1 );
+  }
+
+} // End function: void HitIndex::FillTracks()
+
+
+int HitIndex::Find( const int _sector_index, const int _station, const int _phi_int, const int _theta_int,
+		    const bool _isRPC, const bool _eta_pos ) const {
+
+  std::unordered_map<uint64_t, int>::const_iterator it = last.find( Key( _sector_index, _station, _phi_int, _theta_int, _isRPC, _eta_pos ) );
+  if (it == last.end()) return -1;
+  for (int iHit = it->second; iHit >= 0; iHit = prev[iHit]) {
+    if ( sector_index[iHit] == _sector_index && station[iHit] == _station && phi_int[iHit] == _phi_int &&
+	 theta_int[iHit] == _theta_int && bool(isRPC[iHit]) == _isRPC && bool(eta_pos[iHit]) == _eta_pos )
+      return iHit;
+  }
+  return -1;
+
+} // End function: int HitIndex::Find()
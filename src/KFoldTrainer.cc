@@ -0,0 +1,255 @@
+
+#include "../interface/KFoldTrainer.h"
+#include "../interface/MacroHelper.h"  // GetMedian, GetResScore
+
+#include "TFile.h"
+#include "TH1.h"
+#include "TMVA/Factory.h"
+#include "TMVA/DataLoader.h"
+#include "TMVA/MethodBase.h"
+#include "TMVA/Reader.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdio>
+#include <cmath>
+#include <cassert>
+#include <cerrno>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/wait.h>
+
+
+// Trigger pT from a regression target or output, following the target variable names of PtRegression_Apr_2017.C
+static double KFoldTargToPt( const TString targ, const double val ) {
+  if (targ.BeginsWith("inv_"))  return 1. / fmax(0.001, val);  // Protect against negative 1/pT values
+  if (targ.BeginsWith("log2_")) return pow(2, val);
+  if (targ.BeginsWith("sqrt_")) return pow(val, 2);
+  return val;
+} // End function: double KFoldTargToPt()
+
+
+int KFoldTrainer::Fold( const ULong64_t event_id, const int k ) {
+
+  // splitmix64 finaliser: folds do not follow the even / odd or file structure of the event numbers
+  ULong64_t z = event_id + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z =  z ^ (z >> 31);
+  return int( z % ULong64_t(k) );
+
+} // End function: int KFoldTrainer::Fold()
+
+
+void KFoldTrainer::AddEvent( const ULong64_t event_id, const std::vector<Double_t>& var_vals, const Double_t weight ) {
+
+  assert( var_vals.size() >= var_names.size() );
+  values.insert( values.end(), var_vals.begin(), var_vals.begin() + var_names.size() );
+  weights.push_back( weight );
+  folds.push_back( Fold( event_id, k ) );
+
+} // End function: void KFoldTrainer::AddEvent()
+
+
+bool KFoldTrainer::Run( BookFunc book, std::map<std::string, int>& Use, const TString out_dir ) {
+
+  assert( k >= 2 && k <= 255 && n_procs >= 1 );
+  if ( n_targ != 1 || !var_names.at(n_in).Contains("pt_trg") ) {
+    std::cout << "ERROR: k-fold resolution score needs a single pT target, not " << var_names.at(n_in) << std::endl;
+    return false;
+  }
+
+  std::cout << "\n******* Cross-validating " << name << ": " << k << " folds of " << NEvents()
+	    << " tracks, " << n_procs << " at a time *******" << std::endl;
+  std::cout.flush();  // Nothing buffered is duplicated into the children
+  fflush(stdout);
+
+  std::vector<pid_t>       pids( k, -1 );
+  std::vector<int>         fds ( k, -1 );
+  std::vector<std::string> outputs( k );
+  bool ok = true;
+  int next = 0, running = 0;
+  while (next < k || running > 0) {
+
+    // Start the next fold
+    if (next < k && running < n_procs) {
+      int fd[2];
+      pid_t pid = -1;
+      if (pipe(fd) == 0) pid = fork();
+      if (pid == 0) {
+	close( fd[0] );
+	RunFold( next, book, Use, out_dir, fd[1] );
+	close( fd[1] );
+	_exit(0);  // No exit handlers: the parent's files stay untouched
+      }
+      if (pid < 0) {
+	std::cout << "ERROR: could not start the process for fold " << next << std::endl;
+	ok = false;
+	next += 1;
+	continue;
+      }
+      close( fd[1] );
+      pids.at(next) = pid;
+      fds .at(next) = fd[0];
+      next += 1;
+      running += 1;
+      continue;
+    }
+
+    // Read the outputs of the running folds as they come, so that no fold blocks on a full pipe;
+    // a fold whose pipe is at end-of-file has finished and is reaped
+    std::vector<pollfd> pfds;
+    std::vector<int>    pfolds;
+    for (int iFold = 0; iFold < k; iFold++) {
+      if (fds.at(iFold) < 0) continue;
+      pollfd pfd;
+      pfd.fd      = fds.at(iFold);
+      pfd.events  = POLLIN;
+      pfd.revents = 0;
+      pfds  .push_back( pfd );
+      pfolds.push_back( iFold );
+    }
+    if (pfds.empty()) break;
+    if (poll( pfds.data(), pfds.size(), -1 ) < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    for (UInt_t j = 0; j < pfds.size(); j++) {
+      if (pfds.at(j).revents == 0) continue;
+      const int iFold = pfolds.at(j);
+      char buf[4096];
+      const ssize_t n = read( fds.at(iFold), buf, sizeof(buf) );
+      if (n > 0) {
+	outputs.at(iFold).append( buf, n );
+	continue;
+      }
+      if (n < 0 && errno == EINTR) continue;
+      close( fds.at(iFold) );
+      fds.at(iFold) = -1;
+      int status = 0;
+      if ( waitpid( pids.at(iFold), &status, 0 ) != pids.at(iFold) ||
+	   !WIFEXITED(status) || WEXITSTATUS(status) != 0 || outputs.at(iFold).empty() ) {
+	std::cout << "ERROR: fold " << iFold << " of " << name << " failed" << std::endl;
+	ok = false;
+      }
+      running -= 1;
+    }
+  } // End loop: while (next < k || running > 0)
+
+  // Scores of each method in each fold
+  method_names.clear();
+  scores.clear();
+  for (int iFold = 0; iFold < k; iFold++) {
+    std::istringstream lines( outputs.at(iFold) );
+    std::string meth;
+    double score;
+    while (lines >> meth >> score) {
+      int iMeth = 0;
+      while (iMeth < int(method_names.size()) && method_names.at(iMeth) != meth.c_str()) iMeth++;
+      if (iMeth == int(method_names.size())) {
+	method_names.push_back( meth.c_str() );
+	scores.push_back( std::vector<double>( k, -99 ) );
+      }
+      scores.at(iMeth).at(iFold) = score;
+    }
+  }
+
+  std::cout << "\n" << std::string(60, '*') << "\n" << name << ": resolution score in " << k << " folds\n"
+	    << std::string(60, '*') << std::endl;
+  for (UInt_t iMeth = 0; iMeth < method_names.size(); iMeth++) {
+    double sum = 0, sum2 = 0;
+    int nOK = 0;
+    for (int iFold = 0; iFold < k; iFold++) {
+      if (scores.at(iMeth).at(iFold) < 0) continue;
+      sum  += scores.at(iMeth).at(iFold);
+      sum2 += pow( scores.at(iMeth).at(iFold), 2 );
+      nOK  += 1;
+    }
+    const double mean = (nOK > 0 ? sum / nOK : -99);
+    const double rms  = (nOK > 1 ? sqrt( fmax(0., (sum2 - nOK * mean * mean) / (nOK - 1)) ) : 0);
+    std::cout << std::setw(30) << std::left << method_names.at(iMeth)
+	      << " mean " << std::fixed << std::setprecision(4) << mean << " +/- " << rms
+	      << " (" << nOK << " folds):";
+    for (int iFold = 0; iFold < k; iFold++)
+      std::cout << " " << scores.at(iMeth).at(iFold);
+    std::cout << std::endl;
+  }
+
+  return ok;
+
+} // End function: bool KFoldTrainer::Run()
+
+
+void KFoldTrainer::RunFold( const int iFold, BookFunc book, std::map<std::string, int>& Use, const TString out_dir, const int fd ) {
+
+  TString fold_name;
+  fold_name.Form( "%s_fold%d", name.Data(), iFold );
+  TFile* fold_file = TFile::Open( out_dir+"/"+fold_name+".root", "RECREATE" );
+  if (!fold_file) return;
+
+  TMVA::Factory*    factX = new TMVA::Factory( fold_name, fold_file, "!V:Silent:!Color:!DrawProgressBar:AnalysisType=Regression" );
+  TMVA::DataLoader* loadX = new TMVA::DataLoader( fold_name );
+  const int nVars = var_names.size();
+  for (int iVar = 0; iVar < nVars; iVar++) {
+    if (iVar < n_in) loadX->AddVariable( var_names.at(iVar), 'F' );
+    else             loadX->AddTarget  ( var_names.at(iVar) );
+  }
+
+  // Events of this fold are the test sample, all others the training sample
+  Long64_t nTrain = 0, nTest = 0;
+  std::vector<Double_t> vals( nVars );
+  for (Long64_t iEvt = 0; iEvt < NEvents(); iEvt++) {
+    std::copy( values.begin() + iEvt * nVars, values.begin() + (iEvt + 1) * nVars, vals.begin() );
+    if (folds.at(iEvt) == iFold) { loadX->AddTestEvent    ( "Regression", vals, weights.at(iEvt) ); nTest  += 1; }
+    else                         { loadX->AddTrainingEvent( "Regression", vals, weights.at(iEvt) ); nTrain += 1; }
+  }
+  TString split;
+  split.Form( "nTrain_Regression=%lld:nTest_Regression=%lld:SplitMode=Block:NormMode=NumEvents:!V", nTrain, nTest );
+  loadX->PrepareTrainingAndTestTree( "", split );
+
+  book( factX, loadX, Use );
+  factX->TrainAllMethods();
+
+  // Score the held-out fold with each trained method
+  std::vector<Float_t> in( n_in );
+  TMVA::Reader* reader = new TMVA::Reader( "!Color:Silent" );
+  for (int iVar = 0; iVar < n_in; iVar++)
+    reader->AddVariable( var_names.at(iVar), &(in.at(iVar)) );
+
+  const TString targ = var_names.at(n_in);
+  std::map<TString, std::vector<TMVA::IMethod*>*>::iterator itrMap;
+  for (itrMap = factX->fMethodsMap.begin(); itrMap != factX->fMethodsMap.end(); itrMap++) {
+    for (UInt_t i = 0; i < itrMap->second->size(); i++) {
+      TMVA::MethodBase* theMethod = dynamic_cast<TMVA::MethodBase*>(itrMap->second->at(i));
+      if (!theMethod) continue;
+      const TString meth = theMethod->GetMethodName();
+      if ( !reader->BookMVA( meth, theMethod->GetWeightFileName() ) ) continue;
+
+      // Binning, pT range and 1/sqrt(pT) weights of macros/PtResolution.C
+      TH1D* h_res = new TH1D( "h_res_"+meth, "h_res_"+meth, 1600, -8, 8 );
+      h_res->Sumw2();
+      for (Long64_t iEvt = 0; iEvt < NEvents(); iEvt++) {
+	if (folds.at(iEvt) != iFold) continue;
+	std::copy( values.begin() + iEvt * nVars, values.begin() + iEvt * nVars + n_in, in.begin() );
+	double GEN_pt = KFoldTargToPt( targ, values.at(iEvt * nVars + n_in) );
+	double TRG_pt = KFoldTargToPt( targ, reader->EvaluateRegression( meth ).at(0) );
+	GEN_pt = fmin( 256., fmax( 1., GEN_pt ) );
+	TRG_pt = fmin( 256., fmax( 1., TRG_pt ) );
+	h_res->Fill( log2( TRG_pt / GEN_pt ), 1. / sqrt(GEN_pt) );
+      }
+
+      const Float_t med_ratio = pow( 2, GetMedian( h_res ) );
+      char line[256];
+      const int len = snprintf( line, sizeof(line), "%s %.6f\n", meth.Data(), GetResScore( h_res, med_ratio ) );
+      if ( write( fd, line, len ) != len )
+	std::cout << "ERROR: could not return the score of " << meth << " in fold " << iFold << std::endl;
+      delete h_res;
+    }
+  }
+
+  delete reader;
+  fold_file->Close();
+  std::cout.flush();
+
+} // End function: void KFoldTrainer::RunFold()
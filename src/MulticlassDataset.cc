@@ -0,0 +1,139 @@
+
+#include "../interface/MulticlassDataset.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TObject.h"
+
+#include <iostream>
+#include <cassert>
+
+
+int MulticlassDataset::PtClass( const double pt, const std::vector<double>& bounds ) {
+
+  for (UInt_t i = 0; i < bounds.size(); i++)
+    if (pt >= bounds.at(i)) return i + 1;
+  return bounds.size() + 1;
+
+} // End function: int MulticlassDataset::PtClass()
+
+
+TString MulticlassDataset::SchemeName( const std::vector<double>& bounds ) {
+
+  TString name = "";
+  for (UInt_t i = 0; i < bounds.size(); i++) {
+    TString bound;
+    bound.Form( "%g", bounds.at(i) );
+    bound.ReplaceAll( ".", "p" );
+    name += (i == 0 ? "" : "_") + bound;
+  }
+  return name;
+
+} // End function: TString MulticlassDataset::SchemeName()
+
+
+void MulticlassDataset::Book( const TString tree_name, const std::vector<TString>& _var_names,
+			      const std::vector< std::vector<double> >& _schemes ) {
+
+  var_names = _var_names;
+  schemes   = _schemes;
+  vals  .assign( var_names.size(), 0 );
+  labels.assign( schemes.size(), 0 );
+
+  tree = new TTree( tree_name, tree_name );
+  for (UInt_t iVar = 0; iVar < var_names.size(); iVar++)
+    tree->Branch( var_names.at(iVar), &(vals.at(iVar)), var_names.at(iVar)+"/F" );
+  tree->Branch( "weight", &weight_br, "weight/F" );
+  tree->Branch( "train",  &train_br,  "train/O" );
+  for (UInt_t iSc = 0; iSc < schemes.size(); iSc++) {
+    assert( schemes.at(iSc).size() > 0 && schemes.at(iSc).size() < 255 );
+    TString br_name = "class_"+SchemeName( schemes.at(iSc) );
+    tree->Branch( br_name, &(labels.at(iSc)), br_name+"/b" );
+  }
+
+} // End function: void MulticlassDataset::Book()
+
+
+void MulticlassDataset::Fill( const std::vector<Double_t>& var_vals, const double pt, const double weight, const bool train ) {
+
+  assert( tree && var_vals.size() == vals.size() );
+  for (UInt_t iVar = 0; iVar < vals.size(); iVar++)
+    vals.at(iVar) = var_vals.at(iVar);
+  for (UInt_t iSc = 0; iSc < schemes.size(); iSc++)
+    labels.at(iSc) = PtClass( pt, schemes.at(iSc) );
+  weight_br = weight;
+  train_br  = train;
+  tree->Fill();
+
+} // End function: void MulticlassDataset::Fill()
+
+
+void MulticlassDataset::Write() {
+
+  if (!tree) return;
+  std::cout << "Writing " << tree->GetEntries() << " tracks with " << schemes.size() << " class schemes to "
+	    << tree->GetName() << std::endl;
+  tree->Write( "", TObject::kOverwrite );
+
+} // End function: void MulticlassDataset::Write()
+
+
+bool MulticlassDataset::Open( TFile* file, const TString tree_name, const std::vector<TString>& _var_names,
+			      const std::vector<double>& scheme ) {
+
+  var_names = _var_names;
+  schemes   = std::vector< std::vector<double> >( 1, scheme );
+  iScheme   = 0;
+  vals  .assign( var_names.size(), 0 );
+  labels.assign( 1, 0 );
+
+  tree = (file ? (TTree*) file->Get( tree_name ) : 0);
+  if (!tree) {
+    std::cout << "ERROR: no dataset tree " << tree_name << " in " << (file ? file->GetName() : "(no file)") << std::endl;
+    return false;
+  }
+
+  std::vector<TString> br_names = var_names;
+  br_names.push_back( "weight" );
+  br_names.push_back( "train" );
+  br_names.push_back( "class_"+SchemeName( scheme ) );
+  for (UInt_t i = 0; i < br_names.size(); i++) {
+    if ( !tree->GetBranch( br_names.at(i) ) ) {
+      std::cout << "ERROR: dataset " << tree_name << " has no branch " << br_names.at(i) << std::endl;
+      tree = 0;
+      return false;
+    }
+  }
+
+  tree->SetBranchStatus( "*", 0 );  // Only read the columns of this factory and scheme
+  for (UInt_t i = 0; i < br_names.size(); i++)
+    tree->SetBranchStatus( br_names.at(i), 1 );
+  for (UInt_t iVar = 0; iVar < var_names.size(); iVar++)
+    tree->SetBranchAddress( var_names.at(iVar), &(vals.at(iVar)) );
+  tree->SetBranchAddress( "weight", &weight_br );
+  tree->SetBranchAddress( "train",  &train_br );
+  tree->SetBranchAddress( br_names.back(), &(labels.at(0)) );
+  return true;
+
+} // End function: bool MulticlassDataset::Open()
+
+
+Long64_t MulticlassDataset::Entries() const {
+
+  return (tree ? tree->GetEntries() : 0);
+
+} // End function: Long64_t MulticlassDataset::Entries()
+
+
+int MulticlassDataset::GetEntry( const Long64_t iEnt, std::vector<Double_t>& var_vals, double& weight, bool& train ) {
+
+  assert( tree && iScheme >= 0 );
+  tree->GetEntry( iEnt );
+  var_vals.resize( vals.size() );
+  for (UInt_t iVar = 0; iVar < vals.size(); iVar++)
+    var_vals.at(iVar) = vals.at(iVar);
+  weight = weight_br;
+  train  = train_br;
+  return labels.at(iScheme);
+
+} // End function: int MulticlassDataset::GetEntry()
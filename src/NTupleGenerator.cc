@@ -0,0 +1,310 @@
+
+#include "../interface/NTupleGenerator.h"
+
+#include "TFile.h"
+#include "TDirectory.h"
+#include "TTree.h"
+#include "TObject.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+const int NTupleGenerator::N_GEN;
+const int NTupleGenerator::N_HIT;
+const int NTupleGenerator::N_TRK;
+
+// Default fill values of interface/PtLutInputBranches.hh
+static const int   NTG_DINT = -999;
+static const float NTG_DFLT = -999.0;
+
+// Bending (deg x GeV) at stations 1 - 4 for |eta| = 1.2, and multiple scattering (deg x GeV)
+static const double NTG_BEND[4] = { 15.0, 22.0, 24.0, 25.0 };
+static const double NTG_MSC [4] = {  0.5,  1.0,  1.3,  1.5 };
+
+
+// Leaf list "name[size]/type:..." of a branch struct, from its fields in order
+static TString NTGLeaves( const std::vector< std::pair<TString, char> >& fields, const TString size ) {
+  TString leaves = "";
+  for (UInt_t i = 0; i < fields.size(); i++)
+    leaves += (i == 0 ? "" : ":") + fields.at(i).first + size + "/" + fields.at(i).second;
+  return leaves;
+}
+
+
+TString NTupleGenerator::MuonLeaves() {
+
+  return "nMuons/I:" + NTGLeaves( { {"pt",'F'}, {"eta",'F'}, {"theta",'F'}, {"phi",'F'}, {"charge",'I'} },
+				  TString::Format("[%d]", N_GEN) );
+
+} // End function: TString NTupleGenerator::MuonLeaves()
+
+
+TString NTupleGenerator::HitLeaves() {
+
+  return "nHits/I:" + NTGLeaves( { {"eta",'F'}, {"theta",'F'}, {"phi",'F'}, {"phi_loc",'F'},
+				   {"eta_int",'I'}, {"theta_int",'I'}, {"phi_int",'I'},
+				   {"endcap",'I'}, {"sector",'I'}, {"sector_index",'I'}, {"station",'I'}, {"ring",'I'},
+				   {"CSC_ID",'I'}, {"chamber",'I'}, {"FR",'I'}, {"pattern",'I'},
+				   {"roll",'I'}, {"subsector",'I'}, {"isRPC",'I'}, {"vetoed",'I'} },
+				 TString::Format("[%d]", N_HIT) );
+
+} // End function: TString NTupleGenerator::HitLeaves()
+
+
+TString NTupleGenerator::TrackLeaves() {
+
+  const TString size = TString::Format("[%d]", N_TRK);
+  return "nTracks/I:" +
+    NTGLeaves( { {"pt",'F'}, {"eta",'F'}, {"theta",'F'}, {"phi",'F'}, {"phi_loc",'F'},
+		 {"pt_int",'I'}, {"eta_int",'I'}, {"theta_int",'I'}, {"phi_int",'I'},
+		 {"endcap",'I'}, {"sector",'I'}, {"sector_index",'I'}, {"mode",'I'}, {"charge",'I'},
+		 {"nHits",'I'}, {"nRPC",'I'} }, size ) + ":" +
+    NTGLeaves( { {"hit_eta",'F'}, {"hit_theta",'F'}, {"hit_phi",'F'}, {"hit_phi_loc",'F'},
+		 {"hit_eta_int",'I'}, {"hit_theta_int",'I'}, {"hit_phi_int",'I'},
+		 {"hit_endcap",'I'}, {"hit_sector",'I'}, {"hit_sector_index",'I'}, {"hit_station",'I'}, {"hit_ring",'I'},
+		 {"hit_CSC_ID",'I'}, {"hit_chamber",'I'}, {"hit_FR",'I'}, {"hit_pattern",'I'},
+		 {"hit_roll",'I'}, {"hit_subsector",'I'}, {"hit_isRPC",'I'}, {"hit_vetoed",'I'} }, size + "[4]" );
+
+} // End function: TString NTupleGenerator::TrackLeaves()
+
+
+bool NTupleGenerator::Generate( const TString file_name, const Long64_t n_evt, const bool zero_bias, const ULong64_t seed ) {
+
+  assert( STATION_EFF.size() == 4 && PT_MIN > 0 && PT_MAX > PT_MIN );
+  TFile* file = TFile::Open( file_name, "RECREATE" );
+  if (!file) {
+    std::cout << "ERROR: could not create " << file_name << std::endl;
+    return false;
+  }
+  TDirectory* dir = file->mkdir( "ntuple" );
+  dir->cd();
+  TTree* tree = new TTree( "tree", "tree" );
+  tree->Branch( "muon",  &muon,  MuonLeaves() );
+  tree->Branch( "hit",   &hit,   HitLeaves() );
+  tree->Branch( "track", &track, TrackLeaves() );
+
+  Seed( seed );
+  for (Long64_t iEvt = 0; iEvt < n_evt; iEvt++) {
+    Event( zero_bias );
+    tree->Fill();
+  }
+
+  tree->Write( "", TObject::kOverwrite );
+  file->Close();
+  delete file;
+  return true;
+
+} // End function: bool NTupleGenerator::Generate()
+
+
+void NTupleGenerator::Event( const bool zero_bias ) {
+
+  muon.nMuons   = 0;
+  hit.nHits     = 0;
+  track.nTracks = 0;
+  std::fill( muon.pt, muon.pt + N_GEN, NTG_DFLT );
+
+  if (!zero_bias) {
+    // Single-muon gun
+    double pt = PT_MIN;
+    const double u = Uniform();
+    if      (PT_SPECTRUM == "invPt")  pt = 1. / (1. / PT_MIN - u * (1. / PT_MIN - 1. / PT_MAX));
+    else if (PT_SPECTRUM == "log2Pt") pt = PT_MIN * pow(PT_MAX / PT_MIN, u);
+    else if (PT_SPECTRUM == "pt")     pt = PT_MIN + u * (PT_MAX - PT_MIN);
+    else std::cout << "ERROR: unknown PT_SPECTRUM " << PT_SPECTRUM << std::endl;
+
+    const double eta    = (Uniform() < 0.5 ? -1 : 1) * (ETA_MIN + Uniform() * (ETA_MAX - ETA_MIN));
+    const double phi    = -180. + 360. * Uniform();
+    const int    charge = (Uniform() < 0.5 ? -1 : 1);
+    muon.nMuons    = 1;
+    muon.pt    [0] = pt;
+    muon.eta   [0] = eta;
+    muon.theta [0] = 2. * atan( exp( -fabs(eta) ) ) * 180. / M_PI;
+    muon.phi   [0] = phi;
+    muon.charge[0] = charge;
+    AddMuon( pt, eta, phi, charge );
+  } else {
+    // ZeroBias: steeply falling (pT^-4) muons above 2 GeV, which make the rate
+    const int nMu = std::poisson_distribution<int>( N_ZB_TRK )(rng);
+    for (int iMu = 0; iMu < nMu; iMu++) {
+      const double pt  = 2. * pow( 1. - Uniform(), -1. / 3. );
+      const double eta = (Uniform() < 0.5 ? -1 : 1) * (1.2 + 1.2 * Uniform());
+      AddMuon( pt, eta, -180. + 360. * Uniform(), (Uniform() < 0.5 ? -1 : 1) );
+    }
+  }
+
+  // Pileup hits
+  const int nNoise = std::poisson_distribution<int>( N_PU * HITS_PER_PU )(rng);
+  for (int i = 0; i < nNoise; i++)
+    AddNoiseHit();
+
+} // End function: void NTupleGenerator::Event()
+
+
+// Ring of a station at |eta|, as in the CSC layout
+static int NTGRing( const int station, const double abs_eta ) {
+  if (station == 1) return (abs_eta > 1.6 ? 1 : (abs_eta > 1.2 ? 2 : 3));
+  const double ring1_eta[4] = { 0, 1.6, 1.7, 1.8 };
+  return (abs_eta > ring1_eta[station - 1] ? 1 : 2);
+}
+
+
+void NTupleGenerator::AddMuon( const double pt, const double eta, const double phi, const int charge ) {
+
+  const int    endcap  = (eta > 0 ? 1 : -1);
+  const double theta   = 2. * atan( exp( -fabs(eta) ) ) * 180. / M_PI;
+  const double b_scale = 1.5 - 0.5 * (fabs(eta) - 1.2) / 1.2;  // Less bending at high |eta|
+
+  // Sector from the muon direction at station 2
+  const double phi2   = phi + charge * b_scale * NTG_BEND[1] / pt;
+  const int    sector = 1 + int( fmod( fmod( phi2 - 15., 360. ) + 360., 360. ) / 60. );
+
+  std::vector<int> iHits( 4, -1 );
+  for (int iSt = 0; iSt < 4; iSt++) {
+    const double bend = charge * b_scale * NTG_BEND[iSt] / pt;
+    if (fabs(bend) > 40.) break;  // Curls up before reaching the station
+    if (Uniform() > STATION_EFF.at(iSt)) continue;
+
+    const int  ring  = NTGRing( iSt + 1, fabs(eta) );
+    const bool isRPC = (ring != 1 && Uniform() < RPC_FRAC);  // No RPCs in ring 1
+    const double phi_res = (isRPC ? 0.25 : 0.05);
+    const double th_res  = (isRPC ? 0.50 : 0.20);
+    const double phi_st  = phi + bend + Gauss() * NTG_MSC[iSt] / pt + Gauss() * phi_res;
+    const double th_st   = theta + Gauss() * th_res;
+    iHits.at(iSt) = AddHit( endcap, sector, iSt + 1, ring, isRPC, phi_st, th_st );
+    if (iHits.at(iSt) < 0) continue;
+
+    // Pattern from the local bending: 10 straight, down to 2 / 3 for the most bent
+    const int level = std::min( 4, int( 8. * b_scale / pt ) );
+    if (!isRPC) hit.pattern[ iHits.at(iSt) ] = (level == 0 ? 10 : 10 - 2 * level + (charge > 0));
+
+    // Second LCT in the same chamber
+    if (!isRPC && Uniform() < DUP_FRAC) {
+      const int iDup = AddHit( endcap, sector, iSt + 1, ring, false,
+			       phi_st + (Uniform() < 0.5 ? -1 : 1) * (0.5 + 2.5 * Uniform()), th_st + 6. * (Uniform() - 0.5) );
+      if (iDup >= 0) hit.pattern[iDup] = 2 + int( 9 * Uniform() );
+    }
+  }
+
+  // EMTF track from the muon's hits in at least two stations
+  int mode = 0, nRPC = 0;
+  for (int iSt = 0; iSt < 4; iSt++) {
+    if (iHits.at(iSt) < 0) continue;
+    mode |= (8 >> iSt);
+    nRPC += hit.isRPC[ iHits.at(iSt) ];
+  }
+  const int nSt = (mode >> 3 & 1) + (mode >> 2 & 1) + (mode >> 1 & 1) + (mode & 1);
+  if (nSt < 2 || track.nTracks >= N_TRK) return;
+
+  const int iTrk = track.nTracks;
+  int iRef = -1;  // Hit giving the track theta and phi: station 2 if present
+  for (int iSt : {1, 2, 3, 0})
+    if (iRef < 0 && iHits.at(iSt) >= 0) iRef = iHits.at(iSt);
+
+  const double pt_res = 0.15 + 0.1 * (4 - nSt);
+  const double trk_pt = std::min( 255., pt * exp( pt_res * Gauss() ) );
+  track.pt          [iTrk] = trk_pt;
+  track.pt_int      [iTrk] = std::min( 511, int( 2. * trk_pt ) + 1 );
+  track.eta         [iTrk] = hit.eta      [iRef];
+  track.eta_int     [iTrk] = hit.eta_int  [iRef];
+  track.theta       [iTrk] = hit.theta    [iRef];
+  track.theta_int   [iTrk] = hit.theta_int[iRef];
+  track.phi         [iTrk] = hit.phi      [iRef];
+  track.phi_loc     [iTrk] = hit.phi_loc  [iRef];
+  track.phi_int     [iTrk] = hit.phi_int  [iRef];
+  track.endcap      [iTrk] = endcap;
+  track.sector      [iTrk] = sector;
+  track.sector_index[iTrk] = hit.sector_index[iRef];
+  track.mode        [iTrk] = mode;
+  track.charge      [iTrk] = (Uniform() < std::min( 0.5, pt / 2000. ) ? -charge : charge);  // Charge flips at high pT
+  track.nHits       [iTrk] = nSt;
+  track.nRPC        [iTrk] = nRPC;
+
+  for (int iSt = 0; iSt < 4; iSt++) {
+    const int i = iHits.at(iSt);
+    const bool ok = (i >= 0);
+    track.hit_eta         [iTrk][iSt] = (ok ? hit.eta         [i] : NTG_DFLT);
+    track.hit_theta       [iTrk][iSt] = (ok ? hit.theta       [i] : NTG_DFLT);
+    track.hit_phi         [iTrk][iSt] = (ok ? hit.phi         [i] : NTG_DFLT);
+    track.hit_phi_loc     [iTrk][iSt] = (ok ? hit.phi_loc     [i] : NTG_DFLT);
+    track.hit_eta_int     [iTrk][iSt] = (ok ? hit.eta_int     [i] : NTG_DINT);
+    track.hit_theta_int   [iTrk][iSt] = (ok ? hit.theta_int   [i] : NTG_DINT);
+    track.hit_phi_int     [iTrk][iSt] = (ok ? hit.phi_int     [i] : NTG_DINT);
+    track.hit_endcap      [iTrk][iSt] = (ok ? hit.endcap      [i] : NTG_DINT);
+    track.hit_sector      [iTrk][iSt] = (ok ? hit.sector      [i] : NTG_DINT);
+    track.hit_sector_index[iTrk][iSt] = (ok ? hit.sector_index[i] : NTG_DINT);
+    track.hit_station     [iTrk][iSt] = (ok ? hit.station     [i] : NTG_DINT);
+    track.hit_ring        [iTrk][iSt] = (ok ? hit.ring        [i] : NTG_DINT);
+    track.hit_CSC_ID      [iTrk][iSt] = (ok ? hit.CSC_ID      [i] : NTG_DINT);
+    track.hit_chamber     [iTrk][iSt] = (ok ? hit.chamber     [i] : NTG_DINT);
+    track.hit_FR          [iTrk][iSt] = (ok ? hit.FR          [i] : NTG_DINT);
+    track.hit_pattern     [iTrk][iSt] = (ok ? hit.pattern     [i] : NTG_DINT);
+    track.hit_roll        [iTrk][iSt] = (ok ? hit.roll        [i] : NTG_DINT);
+    track.hit_subsector   [iTrk][iSt] = (ok ? hit.subsector   [i] : NTG_DINT);
+    track.hit_isRPC       [iTrk][iSt] = (ok ? hit.isRPC       [i] : NTG_DINT);
+    track.hit_vetoed      [iTrk][iSt] = (ok ? hit.vetoed      [i] : NTG_DINT);
+  }
+  track.nTracks += 1;
+
+} // End function: void NTupleGenerator::AddMuon()
+
+
+int NTupleGenerator::AddHit( const int endcap, const int sector, const int station, const int ring, const bool isRPC,
+			     const double phi_glob, const double theta_deg ) {
+
+  if (hit.nHits >= N_HIT) return -1;
+  const int i = hit.nHits;
+
+  // EMTF integer conventions: phi_int in 1/60 deg from 22 deg before the sector edge, theta_int in 36.5 / 128 deg from 8.5 deg
+  const double phi_w   = fmod( fmod( phi_glob + 180., 360. ) + 360., 360. ) - 180.;
+  const double phi_loc = fmod( fmod( phi_w - (15. + 60. * (sector - 1)), 360. ) + 540., 360. ) - 180.;
+  const double th      = std::max( 8.6, std::min( 44.9, theta_deg ) );
+  const double abs_eta = -log( tan( th * M_PI / 360. ) );
+
+  hit.eta         [i] = endcap * abs_eta;
+  hit.theta       [i] = th;
+  hit.phi         [i] = phi_w;
+  hit.phi_loc     [i] = phi_loc;
+  hit.eta_int     [i] = int( round( hit.eta[i] / 0.010875 ) );
+  hit.theta_int   [i] = std::max( 5, std::min( 127, int( round( (th - 8.5) * 128. / 36.5 ) ) ) );  // 5 - 127: range of the theta LUT in getTheta()
+  hit.phi_int     [i] = std::max( 0, std::min( 5000, int( round( (phi_loc + 22.) * 60. ) ) ) );
+  hit.endcap      [i] = endcap;
+  hit.sector      [i] = sector;
+  hit.sector_index[i] = sector + 6 * (endcap < 0);
+  hit.station     [i] = station;
+  hit.ring        [i] = ring;
+
+  // 36 chambers of 10 deg, or 18 of 20 deg in ring 1 of stations 2 - 4, chamber 1 centred at phi = 0
+  const double width = (ring == 1 && station > 1 ? 20. : 10.);
+  const int    cham  = 1 + int( fmod( fmod( phi_w + 0.5 * width, 360. ) + 360., 360. ) / width );
+  hit.chamber  [i] = cham;
+  hit.CSC_ID   [i] = 1 + (cham % 3) + 3 * (ring - 1);
+  hit.subsector[i] = (station == 1 ? 1 + ((cham / 3) % 2) : 0);
+  hit.FR       [i] = (station <= 2 ? (cham % 2 == 0) : (cham % 2 == 1));  // As computed in PtRegression_Apr_2017.C
+  if (station == 1 && ring == 3) hit.FR[i] = 0;
+  hit.pattern  [i] = (isRPC ? 0 : 10);  // RPC hits have pattern 0, as CalcBends() expects
+  hit.roll     [i] = (isRPC ? 1 + int( 3 * Uniform() ) : NTG_DINT);
+  hit.isRPC    [i] = isRPC;
+  hit.vetoed   [i] = 0;
+
+  hit.nHits += 1;
+  return i;
+
+} // End function: int NTupleGenerator::AddHit()
+
+
+void NTupleGenerator::AddNoiseHit() {
+
+  const int    endcap  = (Uniform() < 0.5 ? -1 : 1);
+  const int    station = 1 + int( 4 * Uniform() );
+  const double abs_eta = 1.2 + 1.2 * Uniform();
+  const double phi     = -180. + 360. * Uniform();
+  const int    ring    = NTGRing( station, abs_eta );
+  const int    sector  = 1 + int( fmod( fmod( phi - 15., 360. ) + 360., 360. ) / 60. );
+  const bool   isRPC   = (ring != 1 && Uniform() < RPC_FRAC);
+  const int i = AddHit( endcap, sector, station, ring, isRPC, phi, 2. * atan( exp( -abs_eta ) ) * 180. / M_PI );
+  if (i >= 0 && !isRPC) hit.pattern[i] = 2 + int( 9 * Uniform() );
+
+} // End function: void NTupleGenerator::AddNoiseHit()
@@ -0,0 +1,426 @@
+
+#include "../interface/NTupleInput.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TChain.h"
+#include "TChainElement.h"
+#include "TObjArray.h"
+#include "TBranch.h"
+#include "TSystem.h"
+#include "TROOT.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cassert>
+#include <algorithm>
+
+
+NTupleStager::NTupleStager( const std::vector<TString>& _in_file_names, const TString _stage_dir, const int _n_ahead ) {
+
+  in_file_names = _in_file_names;
+  stage_dir     = _stage_dir;
+  n_ahead       = (_n_ahead < 1 ? 1 : _n_ahead);
+  status.assign( in_file_names.size(), kPending );
+  n_released = 0;
+  stop       = false;
+  started    = false;
+
+  if (stage_dir != "" && gSystem->AccessPathName(stage_dir) && gSystem->mkdir(stage_dir, kTRUE) != 0) {
+    std::cout << "ERROR: could not create staging directory " << stage_dir << ", reading files in place" << std::endl;
+    stage_dir = "";
+  }
+
+} // End constructor NTupleStager()
+
+
+NTupleStager::~NTupleStager() {
+
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stop = true;
+  }
+  cv.notify_all();
+  if (thread.joinable())
+    thread.join();
+
+  // Remove copies which were staged but never read
+  for (int i = 0; i < NFiles(); i++)
+    if (status.at(i) == kStaged)
+      std::remove( LocalName(i).Data() );
+
+} // End destructor NTupleStager()
+
+
+TString NTupleStager::LocalName( const int iFile ) const {
+  // Prefix with the index: different input directories often hold files with the same name
+  return Form( "%s/%04d_%s", stage_dir.Data(), iFile, gSystem->BaseName(in_file_names.at(iFile)) );
+}
+
+
+void NTupleStager::Start() {
+
+  if (started || stage_dir == "") return;
+  started = true;
+  ROOT::EnableThreadSafety();  // TFile::Cp runs alongside the reads of the main thread
+  std::cout << "\nStaging input files to " << stage_dir << ", " << n_ahead << " ahead of the current file" << std::endl;
+  thread = std::thread( &NTupleStager::Run, this );
+
+} // End function: void NTupleStager::Start()
+
+
+void NTupleStager::Run() {
+
+  for (int i = 0; i < NFiles(); i++) {
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      cv.wait( lock, [&]{ return stop || i < n_released + n_ahead; } );
+      if (stop) return;
+      if (status.at(i) != kPending) continue;  // Released without being read
+    }
+
+    TString local = LocalName(i);
+    TString tmp   = local + ".tmp";  // Renamed when complete, so a partial copy is never opened
+    bool ok = TFile::Cp( in_file_names.at(i), tmp, kFALSE );
+    ok = ok && (std::rename( tmp.Data(), local.Data() ) == 0);
+    if (!ok) {
+      std::cout << "ERROR: could not stage " << in_file_names.at(i) << " to " << local << std::endl;
+      std::remove( tmp.Data() );
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      status.at(i) = (ok ? kStaged : kFailed);
+    }
+    cv.notify_all();
+  }
+
+} // End function: void NTupleStager::Run()
+
+
+TString NTupleStager::Local( const int iFile ) {
+
+  if (stage_dir == "") return in_file_names.at(iFile);
+  Start();
+
+  std::unique_lock<std::mutex> lock(mtx);
+  cv.wait( lock, [&]{ return status.at(iFile) != kPending; } );
+  return (status.at(iFile) == kStaged ? LocalName(iFile) : TString(""));
+
+} // End function: TString NTupleStager::Local()
+
+
+void NTupleStager::Release( const int iFile ) {
+
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (status.at(iFile) == kReleased) return;
+    if (status.at(iFile) == kStaged)
+      std::remove( LocalName(iFile).Data() );
+    status.at(iFile) = kReleased;
+    n_released += 1;
+  }
+  cv.notify_all();
+
+} // End function: void NTupleStager::Release()
+
+
+NTupleInput::NTupleInput( NTupleStager& _stager, const TString _tree_name, const std::vector<TString>& _branch_names,
+			  const Long64_t _cache_size ) : stager(_stager) {
+
+  tree_name    = _tree_name;
+  branch_names = _branch_names;
+  cache_size   = _cache_size;
+  range_first  =  0;
+  range_last   = -1;  // Up to the end of the chain
+  iFile     = -1;
+  entry     = -1;
+  iList     = -1;
+  fileFirst =  0;
+  fileLast  =  0;
+  chain     =  0;
+  file_entries.assign( stager.NFiles(), -1 );
+
+} // End constructor NTupleInput()
+
+
+NTupleInput::~NTupleInput() {
+
+  if (iFile >= 0 && iFile < stager.NFiles())
+    stager.Release(iFile);
+  delete chain;
+
+} // End destructor NTupleInput()
+
+
+bool NTupleInput::EntriesKnown() const {
+  for (UInt_t i = 0; i < file_entries.size(); i++)
+    if (file_entries.at(i) < 0) return false;
+  return true;
+}
+
+
+Long64_t NTupleInput::FileOffset( const int _iFile ) const {
+  Long64_t offset = 0;
+  for (int i = 0; i < _iFile; i++)
+    offset += file_entries.at(i);
+  return offset;
+}
+
+
+int NTupleInput::FileOf( const Long64_t global_entry ) const {
+  Long64_t offset = 0;
+  for (int i = 0; i < stager.NFiles(); i++) {
+    offset += file_entries.at(i);
+    if (global_entry < offset) return i;
+  }
+  return stager.NFiles();
+}
+
+
+void NTupleInput::SetFileEntries( const std::vector<Long64_t>& _file_entries, const std::vector<Long64_t>& _cluster_starts ) {
+
+  if (chain) {
+    std::cout << "ERROR: NTupleInput::SetFileEntries called after the chain was built, ignoring" << std::endl;
+    return;
+  }
+  assert( int(_file_entries.size()) == stager.NFiles() );
+  file_entries   = _file_entries;
+  cluster_starts = _cluster_starts;
+
+} // End function: void NTupleInput::SetFileEntries()
+
+
+bool NTupleInput::Scan() {
+
+  if (chain) {
+    std::cout << "ERROR: NTupleInput::Scan called after the chain was built, ignoring" << std::endl;
+    return false;
+  }
+
+  std::cout << "\nScanning entries and clusters of " << stager.NFiles() << " input files" << std::endl;
+  cluster_starts.clear();
+  Long64_t offset = 0;
+  for (int i = 0; i < stager.NFiles(); i++) {
+    TFile* file = TFile::Open( stager.in_file_names.at(i) );
+    TTree* tree = (file ? (TTree*) file->Get( tree_name ) : 0);
+    if (!tree) {
+      std::cout << "ERROR: could not read " << tree_name << " from " << stager.in_file_names.at(i) << ", skipping" << std::endl;
+      file_entries.at(i) = 0;
+    } else {
+      file_entries.at(i) = tree->GetEntries();
+      TTree::TClusterIterator clusters = tree->GetClusterIterator(0);
+      Long64_t start;
+      while ( (start = clusters()) < file_entries.at(i) )
+	cluster_starts.push_back( offset + start );
+    }
+    offset += file_entries.at(i);
+    if (file) { file->Close(); delete file; }
+  }
+  cluster_starts.push_back( offset );  // End of the last cluster
+
+  return true;
+} // End function: bool NTupleInput::Scan()
+
+
+void NTupleInput::ClusterRanges( const int n_ranges, std::vector< std::pair<Long64_t, Long64_t> >& ranges ) {
+
+  ranges.clear();
+  if (cluster_starts.empty() && !Scan()) return;
+
+  const Long64_t first = range_first;
+  const Long64_t last  = (range_last >= 0 ? std::min(range_last, cluster_starts.back()) : cluster_starts.back());
+
+  // Each boundary is the first cluster start at or after an equal split of the range
+  Long64_t prev = first;
+  for (int k = 1; k < n_ranges; k++) {
+    Long64_t target = first + ((last - first) * k) / n_ranges;
+    std::vector<Long64_t>::const_iterator it = std::lower_bound( cluster_starts.begin(), cluster_starts.end(), target );
+    Long64_t bound = (it == cluster_starts.end() ? last : std::min(*it, last));
+    if (bound > prev && bound < last) {
+      ranges.push_back( std::make_pair(prev, bound) );
+      prev = bound;
+    }
+  }
+  if (last > prev)
+    ranges.push_back( std::make_pair(prev, last) );
+
+} // End function: void NTupleInput::ClusterRanges()
+
+
+void NTupleInput::SetRange( const Long64_t first, const Long64_t last ) {
+
+  if (chain || !EntriesKnown()) {
+    std::cout << "ERROR: NTupleInput::SetRange needs the file entries and an unused input, ignoring" << std::endl;
+    return;
+  }
+  range_first = first;
+  range_last  = last;
+
+  // Files entirely outside the range are never staged
+  for (int i = 0; i < stager.NFiles(); i++)
+    if (FileOffset(i + 1) <= range_first || FileOffset(i) >= range_last)
+      stager.Release(i);
+
+} // End function: void NTupleInput::SetRange()
+
+
+void NTupleInput::SetEntryList( const std::vector<Long64_t>& _entry_list ) {
+
+  if (chain || !EntriesKnown()) {
+    std::cout << "ERROR: NTupleInput::SetEntryList needs the file entries and an unused input, ignoring" << std::endl;
+    return;
+  }
+  entry_list = _entry_list;
+  assert( std::is_sorted( entry_list.begin(), entry_list.end() ) );
+
+  // Files without any listed entry are never staged
+  std::vector<bool> listed( stager.NFiles(), false );
+  for (UInt_t i = 0; i < entry_list.size(); i++) {
+    int jFile = FileOf( entry_list.at(i) );
+    if (jFile < stager.NFiles()) listed.at(jFile) = true;
+  }
+  for (int i = 0; i < stager.NFiles(); i++)
+    if (!listed.at(i)) stager.Release(i);
+
+} // End function: void NTupleInput::SetEntryList()
+
+
+void NTupleInput::BuildChain() {
+
+  // One element per file (AddFile does not expand wildcards); with known entries no file is opened here
+  chain = new TChain( tree_name );
+  for (int i = 0; i < stager.NFiles(); i++) {
+    if (file_entries.at(i) == 0) continue;
+    chain->AddFile( stager.in_file_names.at(i), (file_entries.at(i) > 0 ? file_entries.at(i) : TTree::kMaxEntries) );
+    chain_files.push_back(i);
+  }
+
+  // Only the requested branches are read; TChain applies the status to every tree it loads
+  chain->SetBranchStatus("*", 0);
+  for (UInt_t i = 0; i < branch_names.size(); i++)
+    chain->SetBranchStatus( branch_names.at(i) + "*", 1 );
+
+} // End function: void NTupleInput::BuildChain()
+
+
+bool NTupleInput::NextFile() {
+
+  const bool first_file = (chain == 0);
+  if (first_file) BuildChain();
+  else if (iFile >= stager.NFiles()) return false;  // Already past the last file
+
+  const Long64_t last = (range_last >= 0 ? range_last : TTree::kMaxEntries);
+  Long64_t next = (first_file ? range_first : fileLast);
+  if (!entry_list.empty()) {
+    // Jump to the next listed entry
+    if (first_file)
+      iList = std::lower_bound( entry_list.begin(), entry_list.end(), range_first ) - entry_list.begin() - 1;
+    next = (iList + 1 < Long64_t(entry_list.size()) ? entry_list.at(iList + 1) : last);
+  }
+  int prev_file = iFile;
+  if (iFile >= 0) stager.Release(iFile);
+
+  int jTree = (first_file ? 0 : chain->GetTreeNumber() + 1);
+  if (EntriesKnown()) {
+    int jFile = FileOf(next);
+    for (jTree = 0; jTree < int(chain_files.size()) && chain_files.at(jTree) < jFile; jTree++) continue;
+  }
+
+  while (jTree < int(chain_files.size()) && next < last) {
+    const int jFile = chain_files.at(jTree);
+
+    // Skipped files (outside the range or empty) are released so that the stager never copies them
+    for (int k = prev_file + 1; k < jFile; k++)
+      stager.Release(k);
+    prev_file = jFile;
+
+    // Point the chain element at the staged copy before the chain opens it
+    TString local = stager.Local(jFile);
+    if (local != "")
+      ((TChainElement*) chain->GetListOfFiles()->At(jTree))->SetTitle( local );
+    else
+      std::cout << "ERROR: could not stage " << stager.in_file_names.at(jFile) << ", reading it in place" << std::endl;
+
+    if (chain->LoadTree(next) < 0) break;  // No readable entries left
+    if (chain->GetTreeNumber() != jTree) {
+      // The chain found no entries in this file, and moved on to a later one (read in place if not yet staged)
+      std::cout << "WARNING: no " << tree_name << " entries in " << stager.in_file_names.at(jFile) << ", skipping" << std::endl;
+      for (int k = jTree; k < chain->GetTreeNumber(); k++)
+	stager.Release( chain_files.at(k) );
+      jTree = chain->GetTreeNumber();
+      prev_file = chain_files.at(jTree);
+    }
+
+    if (first_file) {
+      // The cache belongs to the chain and keeps its branch list across file switches
+      chain->SetCacheSize( cache_size );
+      for (UInt_t i = 0; i < branch_names.size(); i++)
+	chain->AddBranchToCache( branch_names.at(i), kTRUE );
+      if (range_last >= 0)
+	chain->SetCacheEntryRange( range_first, range_last );
+      chain->StopCacheLearningPhase();
+    }
+
+    iFile     = chain_files.at(jTree);
+    fileFirst = next;
+    fileLast  = std::min( chain->GetChainOffset() + chain->GetTree()->GetEntries(), last );
+    entry     = next - 1;
+
+    // Rebind to the branches of the new tree
+    branches.clear();
+    for (UInt_t i = 0; i < branch_names.size(); i++) {
+      TBranch* br = chain->GetBranch( branch_names.at(i) );
+      if (!br)
+	std::cout << "ERROR: no branch " << branch_names.at(i) << " in " << stager.in_file_names.at(iFile) << std::endl;
+      branches.push_back( br );
+    }
+
+    std::cout << "\nReading entries " << fileFirst << " - " << fileLast << " from file " << iFile+1 << " / " << stager.NFiles()
+	      << ": " << stager.in_file_names.at(iFile) << std::endl;
+    return true;
+  }
+
+  // Done: let the stager drop everything left
+  for (int k = prev_file + 1; k < stager.NFiles(); k++)
+    stager.Release(k);
+  iFile = stager.NFiles();
+  branches.clear();
+  return false;
+
+} // End function: bool NTupleInput::NextFile()
+
+
+bool NTupleInput::NextEvent() {
+
+  if (!chain || iFile < 0 || iFile >= stager.NFiles()) return false;
+  if (!entry_list.empty()) {
+    if (iList + 1 >= Long64_t(entry_list.size()) || entry_list.at(iList + 1) >= fileLast) return false;
+    iList += 1;
+    entry = entry_list.at(iList);
+  } else {
+    if (entry + 1 >= fileLast) return false;
+    entry += 1;
+  }
+  chain->GetEntry(entry);
+  return true;
+
+} // End function: bool NTupleInput::NextEvent()
+
+
+bool NTupleInput::Next() {
+
+  while ( !NextEvent() )
+    if ( !NextFile() ) return false;
+  return true;
+
+} // End function: bool NTupleInput::Next()
+
+
+TBranch* NTupleInput::GetBranch( const TString name ) const {
+
+  for (UInt_t i = 0; i < branches.size(); i++)
+    if (branch_names.at(i) == name) return branches.at(i);
+  return 0;
+
+} // End function: TBranch* NTupleInput::GetBranch()
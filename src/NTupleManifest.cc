@@ -0,0 +1,218 @@
+
+#include "../interface/NTupleManifest.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TObjArray.h"
+#include "TSystem.h"
+#include "TROOT.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+const std::string NTUPLE_MANIFEST_TAG = "# EMTFPtAssign2017 NTuple manifest v1";
+
+
+void NTupleManifest::Check( NTupleFileInfo& info ) const {
+
+  info.ok      = false;
+  info.entries = 0;
+  info.branches.clear();
+  info.cluster_starts.clear();
+  info.tree_name = tree_name.Data();
+
+  TFile* file = TFile::Open( info.path.c_str() );
+  TTree* tree = (file ? (TTree*) file->Get( tree_name ) : 0);
+  if (tree) {
+    info.ok      = true;
+    info.entries = tree->GetEntries();
+    TObjArray* br_list = tree->GetListOfBranches();
+    for (int i = 0; i < br_list->GetEntriesFast(); i++)
+      info.branches.push_back( br_list->At(i)->GetName() );
+    TTree::TClusterIterator clusters = tree->GetClusterIterator(0);
+    Long64_t start;
+    while ( (start = clusters()) < info.entries )
+      info.cluster_starts.push_back( start );
+  }
+  if (file) {
+    file->Close();
+    delete file;
+  }
+
+} // End function: void NTupleManifest::Check()
+
+
+void NTupleManifest::Build( const std::vector<TString>& file_names, const TString _sidecar_name ) {
+
+  if (_sidecar_name != "" && !gSystem->AccessPathName(_sidecar_name))
+    Read( _sidecar_name );
+
+  // Stat every file (cheap, also for xrootd) to decide which cached entries are still valid
+  const int nFiles = file_names.size();
+  std::vector<NTupleFileInfo> infos( nFiles );
+  for (int i = 0; i < nFiles; i++) {
+    infos.at(i).path = file_names.at(i).Data();
+    FileStat_t st;
+    if ( gSystem->GetPathInfo( file_names.at(i), st ) == 0 )
+      infos.at(i).mtime = st.fMtime;
+  }
+
+  std::vector<int> to_check;
+  n_cached = 0;
+  for (int i = 0; i < nFiles; i++) {
+    std::map<std::string, NTupleFileInfo>::const_iterator it = files.find( infos.at(i).path );
+    if ( it != files.end() && infos.at(i).mtime >= 0 && it->second.mtime == infos.at(i).mtime &&
+	 it->second.tree_name == tree_name.Data() ) {
+      infos.at(i) = it->second;
+      n_cached += 1;
+    } else if (infos.at(i).mtime >= 0) {
+      to_check.push_back(i);
+    }  // Files which cannot be stat'ed do not exist: left as not ok
+  }
+
+  std::cout << "\nInput manifest: " << n_cached << " / " << nFiles << " files from " << (_sidecar_name == "" ? "(no sidecar)" : _sidecar_name)
+	    << ", checking " << to_check.size() << " with " << n_threads << " threads" << std::endl;
+
+  // Open the remaining files in parallel, each thread taking the next unchecked file
+  if (!to_check.empty()) {
+    ROOT::EnableThreadSafety();
+    std::atomic<int> next(0);
+    std::vector<std::thread> threads;
+    const int nTh = std::max( 1, std::min( n_threads, int(to_check.size()) ) );
+    for (int iTh = 0; iTh < nTh; iTh++) {
+      threads.push_back( std::thread( [&]() {
+	    for (int k = next++; k < int(to_check.size()); k = next++)
+	      Check( infos.at( to_check.at(k) ) );
+	  } ) );
+    }
+    for (int iTh = 0; iTh < nTh; iTh++)
+      threads.at(iTh).join();
+  }
+
+  for (int i = 0; i < nFiles; i++) {
+    if (!infos.at(i).ok)
+      std::cout << "ERROR: could not open data file " << file_names.at(i) << std::endl;
+    files[ infos.at(i).path ] = infos.at(i);
+  }
+
+  if (_sidecar_name != "" && !to_check.empty())
+    Write( _sidecar_name );
+
+} // End function: void NTupleManifest::Build()
+
+
+const NTupleFileInfo& NTupleManifest::Info( const TString file_name ) const {
+
+  static const NTupleFileInfo missing;
+  std::map<std::string, NTupleFileInfo>::const_iterator it = files.find( file_name.Data() );
+  return (it == files.end() ? missing : it->second);
+
+} // End function: const NTupleFileInfo& NTupleManifest::Info()
+
+
+std::vector<TString> NTupleManifest::GoodFiles( const std::vector<TString>& file_names ) const {
+
+  std::vector<TString> good;
+  for (UInt_t i = 0; i < file_names.size(); i++)
+    if ( Info(file_names.at(i)).ok )
+      good.push_back( file_names.at(i) );
+  return good;
+
+} // End function: std::vector<TString> NTupleManifest::GoodFiles()
+
+
+std::vector<Long64_t> NTupleManifest::Entries( const std::vector<TString>& file_names ) const {
+
+  std::vector<Long64_t> entries;
+  for (UInt_t i = 0; i < file_names.size(); i++)
+    entries.push_back( Info(file_names.at(i)).entries );
+  return entries;
+
+} // End function: std::vector<Long64_t> NTupleManifest::Entries()
+
+
+std::vector<Long64_t> NTupleManifest::ClusterStarts( const std::vector<TString>& file_names ) const {
+
+  std::vector<Long64_t> starts;
+  Long64_t offset = 0;
+  for (UInt_t i = 0; i < file_names.size(); i++) {
+    const NTupleFileInfo& info = Info(file_names.at(i));
+    for (UInt_t j = 0; j < info.cluster_starts.size(); j++)
+      starts.push_back( offset + info.cluster_starts.at(j) );
+    offset += info.entries;
+  }
+  starts.push_back( offset );
+  return starts;
+
+} // End function: std::vector<Long64_t> NTupleManifest::ClusterStarts()
+
+
+// One line per file: path mtime ok tree entries branch,branch,... cluster,cluster,...
+bool NTupleManifest::Write( const TString _sidecar_name ) const {
+
+  // Written to a temporary name and renamed, so concurrent jobs never read a partial sidecar
+  TString tmp_name = _sidecar_name + Form(".tmp%d", gSystem->GetPid());
+  std::ofstream out( tmp_name.Data() );
+  if (!out) {
+    std::cout << "ERROR: could not write input manifest " << _sidecar_name << std::endl;
+    return false;
+  }
+  out << NTUPLE_MANIFEST_TAG << "\n";
+  for (std::map<std::string, NTupleFileInfo>::const_iterator it = files.begin(); it != files.end(); ++it) {
+    const NTupleFileInfo& info = it->second;
+    if (info.mtime < 0) continue;
+    out << info.path << " " << info.mtime << " " << info.ok << " " << (info.tree_name == "" ? "-" : info.tree_name) << " " << info.entries << " ";
+    for (UInt_t i = 0; i < info.branches.size(); i++)
+      out << (i > 0 ? "," : "") << info.branches.at(i);
+    out << (info.branches.empty() ? "-" : "") << " ";
+    for (UInt_t i = 0; i < info.cluster_starts.size(); i++)
+      out << (i > 0 ? "," : "") << info.cluster_starts.at(i);
+    out << (info.cluster_starts.empty() ? "-" : "") << "\n";
+  }
+  out.close();
+
+  if ( !out || std::rename( tmp_name.Data(), _sidecar_name.Data() ) != 0 ) {
+    std::cout << "ERROR: could not write input manifest " << _sidecar_name << std::endl;
+    std::remove( tmp_name.Data() );
+    return false;
+  }
+  return true;
+
+} // End function: bool NTupleManifest::Write()
+
+
+bool NTupleManifest::Read( const TString _sidecar_name ) {
+
+  std::ifstream in( _sidecar_name.Data() );
+  std::string line;
+  if ( !in || !std::getline(in, line) || line != NTUPLE_MANIFEST_TAG ) {
+    std::cout << "WARNING: " << _sidecar_name << " is not an input manifest, ignoring it" << std::endl;
+    return false;
+  }
+
+  while ( std::getline(in, line) ) {
+    std::istringstream fields(line);
+    NTupleFileInfo info;
+    std::string branches, clusters, item;
+    if ( !(fields >> info.path >> info.mtime >> info.ok >> info.tree_name >> info.entries >> branches >> clusters) ) {
+      std::cout << "WARNING: skipping malformed line in " << _sidecar_name << ": " << line << std::endl;
+      continue;
+    }
+    if (info.tree_name == "-") info.tree_name = "";
+    std::istringstream br_list(branches);
+    while (branches != "-" && std::getline(br_list, item, ','))
+      info.branches.push_back(item);
+    std::istringstream cl_list(clusters);
+    while (clusters != "-" && std::getline(cl_list, item, ','))
+      info.cluster_starts.push_back( std::stoll(item) );
+    files[info.path] = info;
+  }
+
+  return true;
+} // End function: bool NTupleManifest::Read()
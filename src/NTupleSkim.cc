@@ -0,0 +1,224 @@
+
+#include "../interface/NTupleSkim.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TLeaf.h"
+
+#include <iostream>
+#include <cstring>
+#include <map>
+
+const int NTupleSkim::N_MODE;
+
+
+int NTupleSkim::ModeMask( TBranch* hit_br, TBranch* trk_br ) {
+
+  const int nHits = (hit_br->GetLeaf("nHits"))->GetValue();
+  const int nTrks = (trk_br->GetLeaf("nTracks"))->GetValue();
+
+  // Stations with EMTF tracks or hits, by endcap, as mode bits (station 1 = 8, ..., station 4 = 1)
+  int trk_st[2] = {0, 0};
+  int hit_st[2] = {0, 0};
+  bool any_trk = false;
+  for (int iTrk = 0; iTrk < nTrks; iTrk++) {
+    int mode = (trk_br->GetLeaf("mode"))->GetValue(iTrk);
+    if (mode <= 0 || mode >= N_MODE) continue;
+    trk_st[ (trk_br->GetLeaf("eta"))->GetValue(iTrk) > 0 ] |= mode;
+    any_trk = true;
+  }
+  if (!any_trk) return 0;  // Events without an EMTF track are never used (REQ_EMTF)
+
+  for (int iHit = 0; iHit < nHits; iHit++) {
+    int iSt = (hit_br->GetLeaf("station"))->GetValue(iHit) - 1;
+    if (iSt < 0 || iSt > 3) continue;
+    hit_st[ (hit_br->GetLeaf("eta"))->GetValue(iHit) > 0 ] |= (8 >> iSt);
+  }
+
+  int mask = 1;  // Mode 0: EMTF track information only
+  for (int iEnd = 0; iEnd < 2; iEnd++) {
+    const int avail = trk_st[iEnd] | hit_st[iEnd];
+    for (int mode = 1; mode < N_MODE; mode++)
+      if ( (mode & avail) == mode )
+	mask |= (1 << mode);
+  }
+  return mask;
+
+} // End function: int NTupleSkim::ModeMask()
+
+
+bool NTupleSkim::Create( const TString _file_name ) {
+
+  Close();
+  out_file = TFile::Open( _file_name, "RECREATE" );
+  if (!out_file || out_file->IsZombie()) {
+    std::cout << "ERROR: could not create skim file " << _file_name << std::endl;
+    out_file = 0;
+    return false;
+  }
+
+  file_tree = new TTree("files", "Input files of the skim");
+  file_tree->Branch("path",    b_path,     "path/C");
+  file_tree->Branch("entries", &b_entries, "entries/L");
+  file_tree->Branch("nMC",     &b_nMC,     "nMC/L");
+  file_tree->Branch("nZB",     &b_nZB,     "nZB/L");
+
+  for (int mode = 0; mode < N_MODE; mode++) {
+    TTree* tree = new TTree( Form("mode_%d", mode), Form("Events which can give mode %d tracks", mode) );
+    tree->Branch("iFile",   &b_iFile,   "iFile/I");
+    tree->Branch("entry",   &b_entry,   "entry/L");
+    tree->Branch("ordinal", &b_ordinal, "ordinal/L");
+    tree->Branch("isMC",    &b_isMC,    "isMC/O");
+    mode_trees.push_back( tree );
+  }
+  files.clear();
+
+  return true;
+} // End function: bool NTupleSkim::Create()
+
+
+void NTupleSkim::AddFile( const std::string path, const Long64_t entries, const Long64_t nMC, const Long64_t nZB ) {
+
+  NTupleSkimFile file;
+  file.path    = path;
+  file.entries = entries;
+  file.nMC     = nMC;
+  file.nZB     = nZB;
+  files.push_back( file );
+
+} // End function: void NTupleSkim::AddFile()
+
+
+void NTupleSkim::Fill( const int iFile, const Long64_t entry, const Long64_t ordinal, const bool isMC, const int mode_mask ) {
+
+  b_iFile   = iFile;
+  b_entry   = entry;
+  b_ordinal = ordinal;
+  b_isMC    = isMC;
+  for (int mode = 0; mode < N_MODE; mode++)
+    if ( (mode_mask >> mode) & 1 )
+      mode_trees.at(mode)->Fill();
+
+} // End function: void NTupleSkim::Fill()
+
+
+bool NTupleSkim::Close() {
+
+  if (!out_file) return false;
+
+  for (UInt_t i = 0; i < files.size(); i++) {
+    strncpy( b_path, files.at(i).path.c_str(), sizeof(b_path) - 1 );
+    b_path[sizeof(b_path) - 1] = '\0';
+    b_entries = files.at(i).entries;
+    b_nMC     = files.at(i).nMC;
+    b_nZB     = files.at(i).nZB;
+    file_tree->Fill();
+  }
+
+  out_file->cd();
+  file_tree->Write();
+  for (int mode = 0; mode < N_MODE; mode++)
+    mode_trees.at(mode)->Write();
+  out_file->Close();
+  delete out_file;  // Also deletes the trees
+
+  out_file  = 0;
+  file_tree = 0;
+  mode_trees.clear();
+  return true;
+
+} // End function: bool NTupleSkim::Close()
+
+
+bool NTupleSkim::Select( const TString _file_name, const int mode,
+			 const std::vector<TString>& file_names, const std::vector<Long64_t>& file_entries,
+			 std::vector<Long64_t>& entries, std::vector<Long64_t>& ordinals, std::vector<bool>& isMC ) const {
+
+  entries.clear();
+  ordinals.clear();
+  isMC.clear();
+
+  TFile* in_file = TFile::Open( _file_name );
+  TTree* in_files = (in_file ? (TTree*) in_file->Get("files") : 0);
+  TTree* in_mode  = (in_file ? (TTree*) in_file->Get( Form("mode_%d", mode) ) : 0);
+  if (!in_files || !in_mode) {
+    std::cout << "ERROR: could not read the mode " << mode << " skim from " << _file_name << std::endl;
+    if (in_file) { in_file->Close(); delete in_file; }
+    return false;
+  }
+
+  // Skim files by path
+  char path[1024];
+  Long64_t n_entries, n_MC, n_ZB;
+  in_files->SetBranchAddress("path",    path);
+  in_files->SetBranchAddress("entries", &n_entries);
+  in_files->SetBranchAddress("nMC",     &n_MC);
+  in_files->SetBranchAddress("nZB",     &n_ZB);
+  std::map<std::string, int> skim_index;
+  std::vector<Long64_t> skim_entries, skim_nMC, skim_nZB;
+  for (Long64_t i = 0; i < in_files->GetEntries(); i++) {
+    in_files->GetEntry(i);
+    skim_index[path] = i;
+    skim_entries.push_back( n_entries );
+    skim_nMC    .push_back( n_MC );
+    skim_nZB    .push_back( n_ZB );
+  }
+
+  // Position of each skim file in file_names, with the global entry and ordinal offsets of that order
+  std::vector<int> position( skim_entries.size(), -1 );
+  std::vector<Long64_t> entry_offset( file_names.size() ), MC_offset( file_names.size() ), ZB_offset( file_names.size() );
+  Long64_t sum_entries = 0, sum_MC = 0, sum_ZB = 0;
+  bool ok = true;
+  for (UInt_t i = 0; i < file_names.size(); i++) {
+    std::map<std::string, int>::const_iterator it = skim_index.find( file_names.at(i).Data() );
+    if (it == skim_index.end() || skim_entries.at(it->second) != file_entries.at(i)) {
+      std::cout << "ERROR: " << file_names.at(i) << " is not in skim " << _file_name << ", or has changed since" << std::endl;
+      ok = false;
+      break;
+    }
+    position.at(it->second) = i;
+    entry_offset.at(i) = sum_entries;
+    MC_offset.at(i)    = sum_MC;
+    ZB_offset.at(i)    = sum_ZB;
+    sum_entries += file_entries.at(i);
+    sum_MC += skim_nMC.at(it->second);
+    sum_ZB += skim_nZB.at(it->second);
+  }
+
+  if (ok) {
+    Int_t    iFile;
+    Long64_t entry, ordinal;
+    Bool_t   evt_isMC;
+    in_mode->SetBranchAddress("iFile",   &iFile);
+    in_mode->SetBranchAddress("entry",   &entry);
+    in_mode->SetBranchAddress("ordinal", &ordinal);
+    in_mode->SetBranchAddress("isMC",    &evt_isMC);
+
+    // Rows are sorted by entry within each file; gather them per file, then concatenate in file_names order
+    std::vector< std::vector<Long64_t> > file_rows( file_names.size() );  // Entry and ordinal of each row
+    std::vector< std::vector<bool> >     file_isMC( file_names.size() );
+    for (Long64_t i = 0; i < in_mode->GetEntries(); i++) {
+      in_mode->GetEntry(i);
+      int pos = position.at(iFile);
+      if (pos < 0) continue;  // Skimmed file not read by this job
+      file_rows.at(pos).push_back( entry_offset.at(pos) + entry );
+      file_rows.at(pos).push_back( (evt_isMC ? MC_offset.at(pos) : ZB_offset.at(pos)) + ordinal );
+      file_isMC.at(pos).push_back( evt_isMC );
+    }
+    for (UInt_t pos = 0; pos < file_names.size(); pos++) {
+      for (UInt_t j = 0; j < file_isMC.at(pos).size(); j++) {
+	entries .push_back( file_rows.at(pos).at(2*j) );
+	ordinals.push_back( file_rows.at(pos).at(2*j + 1) );
+	isMC    .push_back( file_isMC.at(pos).at(j) );
+      }
+    }
+    std::cout << "\nSkim " << _file_name << " lists " << entries.size() << " / " << sum_entries
+	      << " entries for mode " << mode << std::endl;
+  }
+
+  in_file->Close();
+  delete in_file;
+  return ok;
+
+} // End function: bool NTupleSkim::Select()
@@ -0,0 +1,142 @@
+
+#include "../interface/ParallelScorer.h"
+
+#include "TTree.h"
+#include "TObject.h"
+#include "TROOT.h"
+#include "TMVA/Reader.h"
+
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <cassert>
+
+const int ParallelScorer::CHUNK;
+
+
+void ParallelScorer::AddEvent( const std::vector<Double_t>& var_vals, const Double_t weight ) {
+
+  assert( var_vals.size() == var_names.size() );
+  values.insert( values.end(), var_vals.begin(), var_vals.end() );
+  weights.push_back( weight );
+
+} // End function: void ParallelScorer::AddEvent()
+
+
+void ParallelScorer::AddMethod( const TString method_name, const TString weight_file ) {
+
+  method_names.push_back( method_name );
+  weight_files.push_back( weight_file );
+
+} // End function: void ParallelScorer::AddMethod()
+
+
+bool ParallelScorer::Score() {
+
+  const Long64_t nEvt    = NEvents();
+  const int      nVars   = var_names.size();
+  const int      nMeth   = method_names.size();
+  const Long64_t nChunks = (nEvt + CHUNK - 1) / CHUNK;
+  const int      nTh     = std::max( 1, int( std::min( Long64_t(n_threads), nChunks ) ) );
+  outputs.assign( Long64_t(nMeth) * nEvt, -99 );
+
+  // Readers are booked serially: TMVA's option parsing and XML reading are not thread-safe
+  std::vector< std::vector<Float_t> > inputs( nTh, std::vector<Float_t>(nVars, 0) );
+  std::vector<TMVA::Reader*> readers;
+  bool ok = true;
+  for (int iTh = 0; iTh < nTh; iTh++) {
+    TMVA::Reader* reader = new TMVA::Reader( "!Color:Silent" );
+    for (int iVar = 0; iVar < nVars; iVar++) {
+      if      (iVar < n_in)           reader->AddVariable ( var_names.at(iVar), &(inputs.at(iTh).at(iVar)) );
+      else if (iVar >= n_in + n_targ) reader->AddSpectator( var_names.at(iVar), &(inputs.at(iTh).at(iVar)) );
+    }
+    for (int iMeth = 0; iMeth < nMeth; iMeth++) {
+      if ( !reader->BookMVA( method_names.at(iMeth), weight_files.at(iMeth) ) ) {
+	std::cout << "ERROR: could not book " << method_names.at(iMeth) << " from " << weight_files.at(iMeth) << std::endl;
+	ok = false;
+      }
+    }
+    readers.push_back( reader );
+  }
+
+  if (ok) {
+    std::cout << "\nScoring " << nEvt << " test events with " << nMeth << " methods on " << nTh << " threads" << std::endl;
+    ROOT::EnableThreadSafety();
+    std::atomic<Long64_t> next(0);
+    std::vector<std::thread> threads;
+    for (int iTh = 0; iTh < nTh; iTh++) {
+      threads.push_back( std::thread( [&, iTh]() {
+	    std::vector<Float_t>& in = inputs.at(iTh);
+	    for (Long64_t iChunk = next++; iChunk < nChunks; iChunk = next++) {
+	      const Long64_t last = std::min( (iChunk + 1) * CHUNK, nEvt );
+	      for (Long64_t iEvt = iChunk * CHUNK; iEvt < last; iEvt++) {
+		std::copy( values.begin() + iEvt * nVars, values.begin() + (iEvt + 1) * nVars, in.begin() );
+		for (int iMeth = 0; iMeth < nMeth; iMeth++)
+		  outputs.at( iMeth * nEvt + iEvt ) = readers.at(iTh)->EvaluateRegression( method_names.at(iMeth) ).at(0);
+	      }
+	    }
+	  } ) );
+    }
+    for (int iTh = 0; iTh < nTh; iTh++)
+      threads.at(iTh).join();
+  }
+
+  for (int iTh = 0; iTh < nTh; iTh++)
+    delete readers.at(iTh);
+  return ok;
+
+} // End function: bool ParallelScorer::Score()
+
+
+void ParallelScorer::WriteTree( const TString tree_name ) const {
+
+  TTree* tree = new TTree( tree_name, tree_name );
+  FillTree( tree );
+  tree->Write( "", TObject::kOverwrite );
+  delete tree;
+
+} // End function: void ParallelScorer::WriteTree()
+
+
+TTree* ParallelScorer::MakeTree( const TString tree_name ) const {
+
+  TTree* tree = new TTree( tree_name, tree_name );
+  tree->SetDirectory(0);  // Baskets stay in memory
+  FillTree( tree );
+  return tree;
+
+} // End function: TTree* ParallelScorer::MakeTree()
+
+
+void ParallelScorer::FillTree( TTree* tree ) const {
+
+  const Long64_t nEvt  = NEvents();
+  const int      nVars = var_names.size();
+  const int      nMeth = method_names.size();
+
+  Int_t   classID = 0;
+  char    className[40];
+  Float_t weight;
+  std::vector<Float_t> vars( nVars );
+  std::vector<Float_t> outs( nMeth );
+  strncpy( className, "Regression", sizeof(className) );
+
+  tree->Branch( "classID",   &classID,  "classID/I" );
+  tree->Branch( "className", className, "className/C" );
+  for (int iVar = 0; iVar < nVars; iVar++)
+    tree->Branch( var_names.at(iVar), &(vars.at(iVar)), var_names.at(iVar)+"/F" );
+  tree->Branch( "weight", &weight, "weight/F" );
+  for (int iMeth = 0; iMeth < nMeth; iMeth++)
+    tree->Branch( method_names.at(iMeth), &(outs.at(iMeth)), method_names.at(iMeth)+"/F" );
+
+  for (Long64_t iEvt = 0; iEvt < nEvt; iEvt++) {
+    std::copy( values.begin() + iEvt * nVars, values.begin() + (iEvt + 1) * nVars, vars.begin() );
+    weight = weights.at(iEvt);
+    for (int iMeth = 0; iMeth < nMeth; iMeth++)
+      outs.at(iMeth) = Output( iMeth, iEvt );
+    tree->Fill();
+  }
+
+} // End function: void ParallelScorer::FillTree()
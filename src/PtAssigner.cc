@@ -0,0 +1,172 @@
+
+#include "../interface/PtAssigner.h"
+#include "../interface/PtLutVarCalc.h"  // Bit-compression of the track variables
+#include "../interface/PtLutFile.h"
+
+#include <iostream>
+#include <cassert>
+
+
+PtAssigner::~PtAssigner() {
+
+  for (int iMode = 0; iMode < 16; iMode++)
+    delete luts.at(iMode);
+
+} // End destructor PtAssigner::~PtAssigner()
+
+
+bool PtAssigner::AddLut( const TString file_name ) {
+
+  PtLutFile* lut = new PtLutFile();
+  if ( !lut->Open( file_name.Data() ) ) {
+    delete lut;
+    return false;
+  }
+  const int mode = lut->header.mode;
+  if (mode < 3 || mode > 15) {
+    std::cout << "ERROR: " << file_name << " has mode " << mode << ", expected a LUT of one track mode" << std::endl;
+    delete lut;
+    return false;
+  }
+  delete luts.at(mode);
+  luts.at(mode) = lut;
+  return true;
+
+} // End function: bool PtAssigner::AddLut()
+
+
+bool PtAssigner::AddBDT( const int mode, const TString weight_file ) {
+
+  assert( mode >= 3 && mode <= 15 );
+  FixedPointBDT& bdt = bdts.at(mode);
+  if ( !bdt.ReadWeightFile( weight_file.Data() ) ) return false;
+
+  PtLutAddressVars vars;
+  bdt_offsets.at(mode).clear();
+  for (int iVar = 0; iVar < bdt.NVars(); iVar++) {
+    const float* ptr = vars.Find( bdt.var_names.at(iVar) );
+    if (ptr == 0) {
+      std::cout << "ERROR: BDT input " << bdt.var_names.at(iVar) << " is not computed from the station hits" << std::endl;
+      bdt = FixedPointBDT();
+      bdt_offsets.at(mode).clear();
+      return false;
+    }
+    bdt_offsets.at(mode).push_back( int( ptr - &vars.theta ) );
+  }
+  return true;
+
+} // End function: bool PtAssigner::AddBDT()
+
+
+bool PtAssigner::HasMode( const int mode ) const {
+
+  if (mode < 0 || mode > 15) return false;
+  return (use_BDT ? bdts.at(mode).NTrees() > 0 : luts.at(mode) != 0);
+
+} // End function: bool PtAssigner::HasMode()
+
+
+int PtAssigner::CalcVars( const PtAssignTrack& trk, PtLutAddressVars& vars, int& dPhSign ) {
+
+  const int mode = trk.mode;
+  int ph[4], th[4], pat[4], FR[4], RPC[4];
+  for (int iSt = 0; iSt < 4; iSt++) {
+    const bool has = ((mode >> (3 - iSt)) & 1);
+    ph [iSt] = (has ? trk.phi    [iSt] : -99);
+    th [iSt] = (has ? trk.theta  [iSt] : -99);
+    pat[iSt] = (has ? trk.pattern[iSt] : -99);
+    FR [iSt] = (has ? trk.FR     [iSt] : -99);
+    RPC[iSt] = (has ? (trk.isRPC [iSt] == 1) : -99);
+  }
+  const int st1_ring2 = (mode >= 8 ? (trk.ring[0] == 2 || trk.ring[0] == 3) : 0);
+
+  int dPh12, dPh13, dPh14, dPh23, dPh24, dPh34;
+  int dPhSum4 = -99, dPhSum4A = -99, dPhSum3 = -99, dPhSum3A = -99, outStPh = -99;
+  int dTh12, dTh13, dTh14, dTh23, dTh24, dTh34;
+  int bend1, bend2, bend3, bend4;
+
+  const int theta = CalcTrackTheta( th[0], th[1], th[2], th[3], st1_ring2, mode, true );
+  CalcDeltaPhis( dPh12, dPh13, dPh14, dPh23, dPh24, dPh34, dPhSign,
+		 dPhSum4, dPhSum4A, dPhSum3, dPhSum3A, outStPh,
+		 ph[0], ph[1], ph[2], ph[3], mode, true );
+  CalcDeltaThetas( dTh12, dTh13, dTh14, dTh23, dTh24, dTh34,
+		   th[0], th[1], th[2], th[3], mode, true );
+  CalcBends( bend1, bend2, bend3, bend4,
+	     pat[0], pat[1], pat[2], pat[3],
+	     dPhSign, trk.endcap, mode, true );
+  CalcRPCs( RPC[0], RPC[1], RPC[2], RPC[3], mode, st1_ring2, theta, true );
+
+  vars.theta   = theta;   vars.St1_ring2 = st1_ring2;
+  vars.dPhi_12 = dPh12;   vars.dPhi_13 = dPh13;   vars.dPhi_14 = dPh14;
+  vars.dPhi_23 = dPh23;   vars.dPhi_24 = dPh24;   vars.dPhi_34 = dPh34;
+  vars.dTh_12  = dTh12;   vars.dTh_13  = dTh13;   vars.dTh_14  = dTh14;
+  vars.dTh_23  = dTh23;   vars.dTh_24  = dTh24;   vars.dTh_34  = dTh34;
+  vars.FR_1    = FR[0];   vars.FR_2    = FR[1];   vars.FR_3    = FR[2];   vars.FR_4    = FR[3];
+  vars.bend_1  = bend1;   vars.bend_2  = bend2;   vars.bend_3  = bend3;   vars.bend_4  = bend4;
+  vars.RPC_1   = RPC[0];  vars.RPC_2   = RPC[1];  vars.RPC_3   = RPC[2];  vars.RPC_4   = RPC[3];
+  vars.dPhiSum4 = dPhSum4;  vars.dPhiSum4A = dPhSum4A;
+  vars.dPhiSum3 = dPhSum3;  vars.dPhiSum3A = dPhSum3A;  vars.outStPhi = outStPh;
+
+  return CalcPtLutAddress( mode, theta, st1_ring2,
+			   dPh12, dPh13, dPh14, dPh23, dPh24, dPh34,
+			   dTh12, dTh13, dTh14, dTh23, dTh24, dTh34,
+			   FR[0], FR[1], FR[2], FR[3],
+			   bend1, bend2, bend3, bend4,
+			   RPC[0], RPC[1], RPC[2], RPC[3] );
+
+} // End function: int PtAssigner::CalcVars()
+
+
+void PtAssigner::Assign( const PtAssignTrack* trks, const int n, PtAssignResult* results ) const {
+
+  // Pass 1: variables and addresses of every track; BDTs are evaluated here, while the variables are at hand
+  std::array<int, 16> n_mode;
+  n_mode.fill( 0 );
+  std::vector<int> in_vars;
+  PtLutAddressVars vars;
+  for (int i = 0; i < n; i++) {
+    const int mode = trks[i].mode;
+    PtAssignResult& res = results[i];
+    res.pt_word = -1;
+    res.pt      = 0;
+    if (mode < 3 || mode > 15 || mode == 4 || mode == 8) {  // No track from a single station
+      res.address = -1;
+      res.charge  = 0;
+      continue;
+    }
+    int dPhSign;
+    res.address = CalcVars( trks[i], vars, dPhSign );
+    res.charge  = dPhSign;
+    if (!HasMode(mode)) continue;
+
+    if (use_BDT) {
+      const std::vector<int>& offsets = bdt_offsets[mode];
+      in_vars.resize( offsets.size() );
+      for (UInt_t iVar = 0; iVar < offsets.size(); iVar++)
+	in_vars[iVar] = int( (&vars.theta)[ offsets[iVar] ] );
+      res.pt_word = bdts[mode].EvalPtWord( in_vars.data() );
+      res.pt      = bdts[mode].PtFromWord( res.pt_word );
+    } else n_mode[mode] += 1;
+  }
+  if (use_BDT) return;
+
+  // Pass 2: batched lookups in the LUT of each mode, so the page and cache-line misses of a batch overlap
+  std::vector<int> idx, addresses, words;
+  for (int mode = 3; mode < 16; mode++) {
+    if (n_mode[mode] == 0) continue;
+    idx.clear();
+    addresses.clear();
+    for (int i = 0; i < n; i++) {
+      if (trks[i].mode != mode) continue;
+      idx.push_back( i );
+      addresses.push_back( results[i].address );
+    }
+    words.resize( idx.size() );
+    luts[mode]->LookupWords( addresses.data(), int(addresses.size()), words.data() );
+    for (UInt_t j = 0; j < idx.size(); j++) {
+      results[idx[j]].pt_word = words[j];
+      results[idx[j]].pt      = luts[mode]->PtFromWord( words[j] );
+    }
+  }
+
+} // End function: void PtAssigner::Assign()
@@ -0,0 +1,418 @@
+
+#include "../interface/PtLutAddress.h"
+#include "../interface/PtLutVarCalc.h"
+#include "../interface/PtAssignmentEngineAux2017.h"
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+
+// Methods are defined in src/PtAssignmentEngineAux2017.cc, included via src/PtLutVarCalc.cc
+static const PtAssignmentEngineAux2017 ENG_LUT;
+
+
+// Raw CLCT pattern (2 - 10) which getCLCT() maps to the compressed bend code, with endcap = +1 and dPhiSign = +1.
+// Any such pattern reproduces the same code when re-compressed with the same convention.
+static int PatternFromBend( const int bend, const int bits ) {
+  for (int pat = 10; pat >= 2; pat--)
+    if (ENG_LUT.getCLCT(pat, 1, 1, bits) == bend)
+      return pat;
+  assert(false);
+  return -1;
+} // End function: static int PatternFromBend()
+
+
+int PtLutModeID( const int mode ) {
+
+  int mode_ID = -1;
+  switch (mode) {
+  case 15: mode_ID = 0b1  ; break;
+  case 14: mode_ID = 0b11 ; break;
+  case 13: mode_ID = 0b10 ; break;
+  case 11: mode_ID = 0b01 ; break;
+  case  7: mode_ID = 0b1  ; break;
+  case 12: mode_ID = 0b111; break;
+  case 10: mode_ID = 0b110; break;
+  case  9: mode_ID = 0b101; break;
+  case  6: mode_ID = 0b100; break;
+  case  5: mode_ID = 0b011; break;
+  case  3: mode_ID = 0b010; break;
+  default: break;
+  }
+
+  assert(mode_ID > 0);
+  return mode_ID;
+} // End function: int PtLutModeID()
+
+
+int PtLutModeFromAddress( const int address ) {
+
+  if      (address >= (1 << 30) || address < 0) return -1;
+  else if (address >= (1 << 29))                return 15;
+  else if (address >= (1 << 27)) {
+    const int mode_3st[4] = {-1, 11, 13, 14};
+    return mode_3st[address >> 27];
+  }
+  else if (address >= (1 << 26))                return 7;
+  else if (address >= (1 << 24)) {
+    const int mode_2st[8] = {-1, -1, 3, 5, 6, 9, 10, 12};
+    return mode_2st[address >> 23];
+  }
+  return -1;
+} // End function: int PtLutModeFromAddress()
+
+
+void PtLutAddressRange( const int mode, int& addr_min, int& n_addr ) {
+
+  const int mode_ID = PtLutModeID(mode);
+  int shift = 23;  // 2-station modes
+  if      (mode == 15) shift = 29;
+  else if (mode ==  7) shift = 26;
+  else if (mode == 14 || mode == 13 || mode == 11) shift = 27;
+
+  addr_min = (mode_ID << shift);
+  n_addr   = (1 << shift);
+} // End function: void PtLutAddressRange()
+
+
+int CalcPtLutAddress( const int mode, const int theta, const int st1_ring2,
+		      const int dPh12, const int dPh13, const int dPh14, const int dPh23, const int dPh24, const int dPh34,
+		      const int dTh12, const int dTh13, const int dTh14, const int dTh23, const int dTh24, const int dTh34,
+		      const int FR1, const int FR2, const int FR3, const int FR4,
+		      const int bend1, const int bend2, const int bend3, const int bend4,
+		      const int RPC1, const int RPC2, const int RPC3, const int RPC4 ) {
+
+  // Look up quantities by station index (0 - 3) and station pair
+  const int dPh[4][4] = { {0, dPh12, dPh13, dPh14}, {0, 0, dPh23, dPh24}, {0, 0, 0, dPh34}, {0, 0, 0, 0} };
+  const int dTh[4][4] = { {0, dTh12, dTh13, dTh14}, {0, 0, dTh23, dTh24}, {0, 0, 0, dTh34}, {0, 0, 0, 0} };
+  const int FR[4]   = {FR1,   FR2,   FR3,   FR4  };
+  const int bend[4] = {bend1, bend2, bend3, bend4};
+  const int RPC[4]  = {RPC1,  RPC2,  RPC3,  RPC4 };
+
+  // Stations in the track, in order: A, B, C, D
+  int st[4] = {-1, -1, -1, -1};
+  int nHits = 0;
+  for (int iSt = 0; iSt < 4; iSt++) {
+    if ( (mode % int(pow(2, 4 - iSt))) / int(pow(2, 3 - iSt)) > 0 ) {
+      st[nHits] = iSt;
+      nHits += 1;
+    }
+  }
+  assert(nHits >= 2);
+
+  const int mode_ID = PtLutModeID(mode);
+  const int frA = (FR[st[0]] == 1);
+  const int frB = (FR[st[1]] == 1);
+
+  int address = 0;
+
+  if (nHits == 4) {
+    int dPhiAB = ENG_LUT.getNLBdPhiBin(dPh[st[0]][st[1]], 7, 512);
+    int dPhiBC = ENG_LUT.getNLBdPhiBin(dPh[st[1]][st[2]], 5, 256);
+    int dPhiCD = ENG_LUT.getNLBdPhiBin(dPh[st[2]][st[3]], 4, 256);
+    int sPhiBC = (dPh[st[1]][st[2]] >= 0);
+    int sPhiCD = (dPh[st[2]][st[3]] >= 0);
+    int dTheta = dTh[st[0]][st[3]];
+
+    // Station 1 bend and RPC hits are packed with theta into 8 bits; a CLCT pattern of 0 flags an RPC hit
+    int theta_ = theta;
+    int st1_ring2_ = st1_ring2;
+    ENG_LUT.unpackTheta(theta_, st1_ring2_, 4);
+    int clctA = (RPC[0] == 1 ? 0 : PatternFromBend(bend[0], 2));
+    int mode15_8b = ENG_LUT.get8bMode15( theta_, st1_ring2_, 1, 1, clctA,
+					 (RPC[1] == 1 ? 0 : 10), (RPC[2] == 1 ? 0 : 10), (RPC[3] == 1 ? 0 : 10) );
+
+    address |= (dPhiAB    & ((1<<7)-1)) << (0);
+    address |= (dPhiBC    & ((1<<5)-1)) << (0+7);
+    address |= (dPhiCD    & ((1<<4)-1)) << (0+7+5);
+    address |= (sPhiBC    & ((1<<1)-1)) << (0+7+5+4);
+    address |= (sPhiCD    & ((1<<1)-1)) << (0+7+5+4+1);
+    address |= (dTheta    & ((1<<2)-1)) << (0+7+5+4+1+1);
+    address |= (frA       & ((1<<1)-1)) << (0+7+5+4+1+1+2);
+    address |= (mode15_8b & ((1<<8)-1)) << (0+7+5+4+1+1+2+1);
+    address |= (mode_ID   & ((1<<1)-1)) << (0+7+5+4+1+1+2+1+8);
+    assert(address < pow(2, 30) && address >= pow(2, 29));
+  }
+
+  else if (nHits == 3) {
+    int dPhiAB = ENG_LUT.getNLBdPhiBin(dPh[st[0]][st[1]], 7, 512);
+    int dPhiBC = ENG_LUT.getNLBdPhiBin(dPh[st[1]][st[2]], 5, 256);
+    int sPhiBC = (dPh[st[1]][st[2]] >= 0);
+    int dTheta = dTh[st[0]][st[2]];
+    int clctA  = bend[st[0]];
+    int rpc_2b = ENG_LUT.get2bRPC( (RPC[st[0]] == 1 ? 0 : 1), (RPC[st[1]] == 1 ? 0 : 1), (RPC[st[2]] == 1 ? 0 : 1) );
+
+    address |= (dPhiAB    & ((1<<7)-1)) << (0);
+    address |= (dPhiBC    & ((1<<5)-1)) << (0+7);
+    address |= (sPhiBC    & ((1<<1)-1)) << (0+7+5);
+    address |= (dTheta    & ((1<<3)-1)) << (0+7+5+1);
+    address |= (frA       & ((1<<1)-1)) << (0+7+5+1+3);
+    int bit = 0;
+    if (mode != 7) {
+      address |= (frB     & ((1<<1)-1)) << (0+7+5+1+3+1);
+      bit = 1;
+    }
+    address |= (clctA     & ((1<<2)-1)) << (0+7+5+1+3+1+bit);
+    address |= (rpc_2b    & ((1<<2)-1)) << (0+7+5+1+3+1+bit+2);
+    address |= (theta     & ((1<<5)-1)) << (0+7+5+1+3+1+bit+2+2);
+    if (mode != 7) {
+      address |= (mode_ID & ((1<<2)-1)) << (0+7+5+1+3+1+bit+2+2+5);
+      assert(address < pow(2, 29) && address >= pow(2, 27));
+    } else {
+      address |= (mode_ID & ((1<<1)-1)) << (0+7+5+1+3+1+bit+2+2+5);
+      assert(address < pow(2, 27) && address >= pow(2, 26));
+    }
+  }
+
+  else if (nHits == 2) {
+    int dPhiAB = ENG_LUT.getNLBdPhiBin(dPh[st[0]][st[1]], 7, 512);
+    int dTheta = dTh[st[0]][st[1]];
+    int clctA  = bend[st[0]];  // 3-bit bend code 0 already flags an RPC hit
+    int clctB  = bend[st[1]];
+
+    address |= (dPhiAB    & ((1<<7)-1)) << (0);
+    address |= (dTheta    & ((1<<3)-1)) << (0+7);
+    address |= (frA       & ((1<<1)-1)) << (0+7+3);
+    address |= (frB       & ((1<<1)-1)) << (0+7+3+1);
+    address |= (clctA     & ((1<<3)-1)) << (0+7+3+1+1);
+    address |= (clctB     & ((1<<3)-1)) << (0+7+3+1+1+3);
+    address |= (theta     & ((1<<5)-1)) << (0+7+3+1+1+3+3);
+    address |= (mode_ID   & ((1<<3)-1)) << (0+7+3+1+1+3+3+5);
+    assert(address < pow(2, 26) && address >= pow(2, 24));
+  }
+
+  return address;
+} // End function: int CalcPtLutAddress()
+
+
+int UnpackPtLutAddress( const int address, PtLutAddressVars& vars ) {
+
+  const int mode = PtLutModeFromAddress(address);
+  if (mode < 0) return mode;
+
+  vars = PtLutAddressVars();
+
+  // Stations in the track, in order: A, B, C, D
+  int st[4] = {-1, -1, -1, -1};
+  int nHits = 0;
+  for (int iSt = 0; iSt < 4; iSt++) {
+    if ( (mode % int(pow(2, 4 - iSt))) / int(pow(2, 3 - iSt)) > 0 ) {
+      st[nHits] = iSt;
+      nHits += 1;
+    }
+  }
+
+  float* dPh[4][4] = { {0, &vars.dPhi_12, &vars.dPhi_13, &vars.dPhi_14}, {0, 0, &vars.dPhi_23, &vars.dPhi_24},
+		       {0, 0, 0, &vars.dPhi_34}, {0, 0, 0, 0} };
+  float* dTh[4][4] = { {0, &vars.dTh_12,  &vars.dTh_13,  &vars.dTh_14},  {0, 0, &vars.dTh_23,  &vars.dTh_24},
+		       {0, 0, 0, &vars.dTh_34},  {0, 0, 0, 0} };
+  float* FR[4]   = {&vars.FR_1,   &vars.FR_2,   &vars.FR_3,   &vars.FR_4  };
+  float* bend[4] = {&vars.bend_1, &vars.bend_2, &vars.bend_3, &vars.bend_4};
+  float* RPC[4]  = {&vars.RPC_1,  &vars.RPC_2,  &vars.RPC_3,  &vars.RPC_4 };
+  for (int i = 0; i < nHits; i++)
+    *RPC[st[i]] = 0;
+
+  // Read the fields back in the order they were packed
+  int pos = 0;
+  #define PT_LUT_FIELD(nBits) ( (address >> ((pos += (nBits)) - (nBits))) & ((1 << (nBits)) - 1) )
+
+  if (nHits == 4) {
+    int dPhiAB    = PT_LUT_FIELD(7);
+    int dPhiBC    = PT_LUT_FIELD(5);
+    int dPhiCD    = PT_LUT_FIELD(4);
+    int sPhiBC    = PT_LUT_FIELD(1);
+    int sPhiCD    = PT_LUT_FIELD(1);
+    int dTheta    = PT_LUT_FIELD(2);
+    int frA       = PT_LUT_FIELD(1);
+    int mode15_8b = PT_LUT_FIELD(8);
+
+    int theta, st1_ring2, clctA, rpcA, rpcB, rpcC, rpcD;
+    ENG_LUT.unpack8bMode15( mode15_8b, theta, st1_ring2, 1, 1, clctA, rpcA, rpcB, rpcC, rpcD );
+
+    vars.theta     = theta;
+    vars.St1_ring2 = st1_ring2;
+    vars.dPhi_12   = ENG_LUT.getdPhiFromBin(dPhiAB, 7, 512);
+    vars.dPhi_23   = ENG_LUT.getdPhiFromBin(dPhiBC, 5, 256) * (sPhiBC ? 1 : -1);
+    vars.dPhi_34   = ENG_LUT.getdPhiFromBin(dPhiCD, 4, 256) * (sPhiCD ? 1 : -1);
+    vars.dPhi_13   = vars.dPhi_12 + vars.dPhi_23;
+    vars.dPhi_14   = vars.dPhi_13 + vars.dPhi_34;
+    vars.dPhi_24   = vars.dPhi_23 + vars.dPhi_34;
+    vars.dTh_14    = dTheta;
+    vars.FR_1      = frA;
+    vars.bend_1    = clctA;
+    vars.RPC_1 = rpcA; vars.RPC_2 = rpcB; vars.RPC_3 = rpcC; vars.RPC_4 = rpcD;
+
+    int dPhSum4, dPhSum4A, dPhSum3, dPhSum3A, outStPh;
+    CalcDeltaPhiSums( dPhSum4, dPhSum4A, dPhSum3, dPhSum3A, outStPh,
+		      vars.dPhi_12, vars.dPhi_13, vars.dPhi_14, vars.dPhi_23, vars.dPhi_24, vars.dPhi_34 );
+    vars.dPhiSum4 = dPhSum4; vars.dPhiSum4A = dPhSum4A; vars.dPhiSum3 = dPhSum3; vars.dPhiSum3A = dPhSum3A;
+    vars.outStPhi = outStPh;
+  }
+
+  else if (nHits == 3) {
+    int dPhiAB = PT_LUT_FIELD(7);
+    int dPhiBC = PT_LUT_FIELD(5);
+    int sPhiBC = PT_LUT_FIELD(1);
+    int dTheta = PT_LUT_FIELD(3);
+    int frA    = PT_LUT_FIELD(1);
+    int frB    = (mode != 7 ? PT_LUT_FIELD(1) : -99);
+    int clctA  = PT_LUT_FIELD(2);
+    int rpc_2b = PT_LUT_FIELD(2);
+    int theta  = PT_LUT_FIELD(5);
+
+    int rpcA, rpcB, rpcC;
+    ENG_LUT.unpack2bRPC(rpc_2b, rpcA, rpcB, rpcC);
+
+    *dPh[st[0]][st[1]] = ENG_LUT.getdPhiFromBin(dPhiAB, 7, 512);
+    *dPh[st[1]][st[2]] = ENG_LUT.getdPhiFromBin(dPhiBC, 5, 256) * (sPhiBC ? 1 : -1);
+    *dPh[st[0]][st[2]] = *dPh[st[0]][st[1]] + *dPh[st[1]][st[2]];
+    *dTh[st[0]][st[2]] = dTheta;
+    *FR[st[0]]   = frA;
+    if (mode != 7)
+      *FR[st[1]] = frB;
+    *bend[st[0]] = clctA;
+    *RPC[st[0]]  = rpcA;
+    *RPC[st[1]]  = rpcB;
+    *RPC[st[2]]  = rpcC;
+    vars.theta     = theta;
+    vars.St1_ring2 = (st[0] == 0 ? ENG_LUT.unpackSt1Ring2(theta, 5) : 0);
+  }
+
+  else if (nHits == 2) {
+    int dPhiAB = PT_LUT_FIELD(7);
+    int dTheta = PT_LUT_FIELD(3);
+    int frA    = PT_LUT_FIELD(1);
+    int frB    = PT_LUT_FIELD(1);
+    int clctA  = PT_LUT_FIELD(3);
+    int clctB  = PT_LUT_FIELD(3);
+    int theta  = PT_LUT_FIELD(5);
+
+    *dPh[st[0]][st[1]] = ENG_LUT.getdPhiFromBin(dPhiAB, 7, 512);
+    *dTh[st[0]][st[1]] = dTheta;
+    *FR[st[0]]   = frA;
+    *FR[st[1]]   = frB;
+    *bend[st[0]] = clctA;
+    *bend[st[1]] = clctB;
+    *RPC[st[0]]  = (clctA == 0);  // 3-bit bend code 0 flags an RPC hit
+    *RPC[st[1]]  = (clctB == 0);
+    vars.theta     = theta;
+    vars.St1_ring2 = (st[0] == 0 ? ENG_LUT.unpackSt1Ring2(theta, 5) : 0);
+  }
+
+  #undef PT_LUT_FIELD
+
+  return mode;
+} // End function: int UnpackPtLutAddress()
+
+
+float* PtLutAddressVars::Find( const TString name ) {
+
+  if (name == "theta")     return &theta;
+  if (name == "St1_ring2") return &St1_ring2;
+  if (name == "dPhi_12")   return &dPhi_12;
+  if (name == "dPhi_13")   return &dPhi_13;
+  if (name == "dPhi_14")   return &dPhi_14;
+  if (name == "dPhi_23")   return &dPhi_23;
+  if (name == "dPhi_24")   return &dPhi_24;
+  if (name == "dPhi_34")   return &dPhi_34;
+  if (name == "dTh_12")    return &dTh_12;
+  if (name == "dTh_13")    return &dTh_13;
+  if (name == "dTh_14")    return &dTh_14;
+  if (name == "dTh_23")    return &dTh_23;
+  if (name == "dTh_24")    return &dTh_24;
+  if (name == "dTh_34")    return &dTh_34;
+  if (name == "FR_1")      return &FR_1;
+  if (name == "FR_2")      return &FR_2;
+  if (name == "FR_3")      return &FR_3;
+  if (name == "FR_4")      return &FR_4;
+  if (name == "bend_1")    return &bend_1;
+  if (name == "bend_2")    return &bend_2;
+  if (name == "bend_3")    return &bend_3;
+  if (name == "bend_4")    return &bend_4;
+  if (name == "RPC_1")     return &RPC_1;
+  if (name == "RPC_2")     return &RPC_2;
+  if (name == "RPC_3")     return &RPC_3;
+  if (name == "RPC_4")     return &RPC_4;
+  if (name == "dPhiSum4")  return &dPhiSum4;
+  if (name == "dPhiSum4A") return &dPhiSum4A;
+  if (name == "dPhiSum3")  return &dPhiSum3;
+  if (name == "dPhiSum3A") return &dPhiSum3A;
+  if (name == "outStPhi")  return &outStPhi;
+  return 0;
+} // End function: float* PtLutAddressVars::Find()
+
+
+// Variables that enter the address, in the bit order of PtLutAddressVars::missing; the dPhi sums are derived
+static const char* PLANames[26] = { "theta", "St1_ring2",
+				    "dPhi_12", "dPhi_13", "dPhi_14", "dPhi_23", "dPhi_24", "dPhi_34",
+				    "dTh_12",  "dTh_13",  "dTh_14",  "dTh_23",  "dTh_24",  "dTh_34",
+				    "FR_1",   "FR_2",   "FR_3",   "FR_4",
+				    "bend_1", "bend_2", "bend_3", "bend_4",
+				    "RPC_1",  "RPC_2",  "RPC_3",  "RPC_4" };
+
+// Bits of PLANames read by CalcPtLutAddress() for a mode.  The RPC flags are optional (absent without
+// USE_RPC, then every hit is a CSC hit), and St1_ring2 is unpacked from the mode 15 theta.
+static UInt_t PLAInputs( const int mode ) {
+
+  const int dPh[4][4] = { {-1, 2, 3, 4}, {-1, -1, 5, 6}, {-1, -1, -1, 7}, {-1, -1, -1, -1} };
+  int st[4] = {-1, -1, -1, -1};
+  int nHits = 0;
+  for (int iSt = 0; iSt < 4; iSt++)
+    if ( (mode >> (3 - iSt)) & 0x1 ) st[nHits++] = iSt;
+  if (nHits < 2 || mode > 15) return 0;
+
+  UInt_t bits = (1 << 0);                            // theta
+  for (int i = 0; i + 1 < nHits; i++)
+    bits |= (1 << dPh[st[i]][st[i+1]]);              // dPhi AB, BC, CD
+  bits |= (1 << (dPh[st[0]][st[nHits - 1]] + 6));    // dTheta between the first and last stations
+  bits |= (1 << (14 + st[0])) | (1 << (18 + st[0])); // frA, bend A
+  if (nHits == 2 || (nHits == 3 && mode != 7))
+    bits |= (1 << (14 + st[1]));                     // frB
+  if (nHits == 2)
+    bits |= (1 << (18 + st[1]));                     // bend B
+  return bits;
+
+} // End function: static UInt_t PLAInputs()
+
+
+bool PtLutAddressVars::SetBranches( TChain* chain, const int mode ) {
+
+  missing = 0;
+  for (int i = 0; i < 26; i++) {
+    if ( !chain->GetBranch(PLANames[i]) ) {
+      missing |= (1 << i);
+      continue;
+    }
+    if ( chain->SetBranchAddress( PLANames[i], Find(PLANames[i]) ) < 0 ) {
+      std::cout << "ERROR: could not read branch " << PLANames[i] << " of " << chain->GetName() << " as a float" << std::endl;
+      missing |= (1 << i);
+    }
+  }
+
+  // Modes of the LUT whose address needs a missing branch: Address() returns -1 for them
+  bool ok = true;
+  for (int iMode = (mode > 0 ? mode : 3); iMode <= (mode > 0 ? mode : 15); iMode++) {
+    const UInt_t lost = (missing & PLAInputs(iMode));
+    if (lost == 0) continue;
+    std::cout << "ERROR: " << chain->GetName() << " has no branch";
+    for (int i = 0; i < 26; i++)
+      if ( (lost >> i) & 0x1 ) std::cout << " " << PLANames[i];
+    std::cout << ", needed for the mode " << iMode << " LUT address: skipping mode " << iMode << " tracks" << std::endl;
+    if (mode > 0) ok = false;
+  }
+  return ok;
+
+} // End function: bool PtLutAddressVars::SetBranches()
+
+
+int PtLutAddressVars::Address( const int mode ) const {
+
+  if ( missing & PLAInputs(mode) ) return -1;  // Not read from the tree: never reaches the LUT code asserts
+  return CalcPtLutAddress( mode, lround(theta), (St1_ring2 == 1),
+			   lround(dPhi_12), lround(dPhi_13), lround(dPhi_14), lround(dPhi_23), lround(dPhi_24), lround(dPhi_34),
+			   lround(dTh_12),  lround(dTh_13),  lround(dTh_14),  lround(dTh_23),  lround(dTh_24),  lround(dTh_34),
+			   lround(FR_1),   lround(FR_2),   lround(FR_3),   lround(FR_4),
+			   lround(bend_1), lround(bend_2), lround(bend_3), lround(bend_4),
+			   lround(RPC_1),  lround(RPC_2),  lround(RPC_3),  lround(RPC_4) );
+
+} // End function: int PtLutAddressVars::Address()
@@ -0,0 +1,204 @@
+
+#include "../interface/PtLutDiff.h"
+#include "../interface/PtLutAddress.h"
+
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <cmath>
+
+// Out-of-class definitions, needed when the constants are bound to references (std::min, std::max)
+const int PtLutDiff::N_MODE;
+const int PtLutDiff::N_THETA;
+const int PtLutDiff::N_RPC;
+const int PtLutDiff::N_DPHI;
+const int PtLutDiff::MAX_SHIFT;
+
+
+// Min-heap on |shift|: the root is the smallest of the current top N
+static bool PtLutShiftGreater( const PtLutShift& a, const PtLutShift& b ) {
+  if (a.AbsShift() != b.AbsShift()) return a.AbsShift() > b.AbsShift();
+  return a.address < b.address;
+} // End function: static bool PtLutShiftGreater()
+
+
+void PtLutDiff::Reset() {
+
+  n_compared = 0;
+  n_changed  = 0;
+  n_changed_mode .assign( N_MODE, 0 );
+  n_changed_theta.assign( N_MODE * N_THETA, 0 );
+  n_changed_RPC  .assign( N_MODE * N_RPC,   0 );
+  n_changed_dPhi .assign( N_MODE * N_DPHI,  0 );
+  sum_shift_theta.assign( N_MODE * N_THETA, 0 );
+  sum_shift_RPC  .assign( N_MODE * N_RPC,   0 );
+  sum_shift_dPhi .assign( N_MODE * N_DPHI,  0 );
+  shift_hist     .assign( N_MODE * (2*MAX_SHIFT + 1), 0 );
+  top.clear();
+
+} // End function: void PtLutDiff::Reset()
+
+
+void PtLutDiff::PushTop( const PtLutShift& shift ) {
+
+  if (n_top <= 0) return;
+  if ( int(top.size()) < n_top ) {
+    top.push_back( shift );
+    std::push_heap( top.begin(), top.end(), PtLutShiftGreater );
+  } else if ( PtLutShiftGreater( shift, top.front() ) ) {
+    std::pop_heap( top.begin(), top.end(), PtLutShiftGreater );
+    top.back() = shift;
+    std::push_heap( top.begin(), top.end(), PtLutShiftGreater );
+  }
+
+} // End function: void PtLutDiff::PushTop()
+
+
+void PtLutDiff::Add( const int address, const int word_A, const int word_B ) {
+
+  PtLutAddressVars vars;
+  int mode = UnpackPtLutAddress( address, vars );
+  if (mode < 0) mode = 0;  // Outside the 2017 layout
+
+  const int shift = word_B - word_A;
+  const int theta = std::min( std::max( int(lround(vars.theta)), 0 ), N_THETA - 1 );
+  const int RPC   = 8*(vars.RPC_1 == 1) + 4*(vars.RPC_2 == 1) + 2*(vars.RPC_3 == 1) + (vars.RPC_4 == 1);
+  const int dPhi  = address & (N_DPHI - 1);
+
+  n_changed += 1;
+  n_changed_mode .at(mode) += 1;
+  n_changed_theta.at(mode * N_THETA + theta) += 1;
+  n_changed_RPC  .at(mode * N_RPC   + RPC)   += 1;
+  n_changed_dPhi .at(mode * N_DPHI  + dPhi)  += 1;
+  sum_shift_theta.at(mode * N_THETA + theta) += shift;
+  sum_shift_RPC  .at(mode * N_RPC   + RPC)   += shift;
+  sum_shift_dPhi .at(mode * N_DPHI  + dPhi)  += shift;
+  shift_hist.at( mode * (2*MAX_SHIFT + 1) + std::min( std::max(shift, -MAX_SHIFT), MAX_SHIFT ) + MAX_SHIFT ) += 1;
+
+  PtLutShift lut_shift;
+  lut_shift.address = address;
+  lut_shift.word_A  = word_A;
+  lut_shift.word_B  = word_B;
+  PushTop( lut_shift );
+
+} // End function: void PtLutDiff::Add()
+
+
+void PtLutDiff::Merge( const PtLutDiff& other ) {
+
+  n_compared += other.n_compared;
+  n_changed  += other.n_changed;
+  for (size_t i = 0; i < n_changed_mode .size(); i++) n_changed_mode .at(i) += other.n_changed_mode .at(i);
+  for (size_t i = 0; i < n_changed_theta.size(); i++) n_changed_theta.at(i) += other.n_changed_theta.at(i);
+  for (size_t i = 0; i < n_changed_RPC  .size(); i++) n_changed_RPC  .at(i) += other.n_changed_RPC  .at(i);
+  for (size_t i = 0; i < n_changed_dPhi .size(); i++) n_changed_dPhi .at(i) += other.n_changed_dPhi .at(i);
+  for (size_t i = 0; i < sum_shift_theta.size(); i++) sum_shift_theta.at(i) += other.sum_shift_theta.at(i);
+  for (size_t i = 0; i < sum_shift_RPC  .size(); i++) sum_shift_RPC  .at(i) += other.sum_shift_RPC  .at(i);
+  for (size_t i = 0; i < sum_shift_dPhi .size(); i++) sum_shift_dPhi .at(i) += other.sum_shift_dPhi .at(i);
+  for (size_t i = 0; i < shift_hist     .size(); i++) shift_hist     .at(i) += other.shift_hist     .at(i);
+  for (size_t i = 0; i < other.top.size(); i++)
+    PushTop( other.top.at(i) );
+
+} // End function: void PtLutDiff::Merge()
+
+
+// Same stored addresses: compare the packed words of entries [idx_first, idx_last), 8 words at a time
+static void ComparePacked( const PtLutFile& lut_A, const PtLutFile& lut_B,
+			   const uint64_t idx_first, const uint64_t idx_last, PtLutDiff& diff ) {
+
+  const uint64_t* a = lut_A.Data();
+  const uint64_t* b = lut_B.Data();
+  const uint64_t bits    = lut_A.header.entry_bits;
+  const uint64_t w_first = (idx_first * bits) >> 6;
+  const uint64_t w_last  = (idx_last  * bits + 63) >> 6;
+  const int BLOCK = 8;
+
+  uint64_t next_idx = idx_first;  // Entries straddling two blocks are checked only once
+  for (uint64_t w = w_first; w < w_last; w += BLOCK) {
+    const uint64_t w_end = std::min( w + BLOCK, w_last );
+    uint64_t x = 0;
+    for (uint64_t i = w; i < w_end; i++)
+      x |= a[i] ^ b[i];
+    if (x == 0) continue;
+
+    uint64_t idx     = std::max( next_idx, (w * 64) / bits );
+    uint64_t idx_end = std::min( idx_last, (w_end * 64 + bits - 1) / bits );
+    for (; idx < idx_end; idx++) {
+      int word_A = lut_A.WordAt(idx);
+      int word_B = lut_B.WordAt(idx);
+      if (word_A != word_B)
+	diff.Add( lut_A.AddressAt(idx), word_A, word_B );
+    }
+    next_idx = idx_end;
+  }
+  diff.n_compared += idx_last - idx_first;
+
+} // End function: static void ComparePacked()
+
+
+// Different coverage or packing: compare address by address, skipping those a sparse LUT leaves out as unreachable
+static void CompareAddresses( const PtLutFile& lut_A, const PtLutFile& lut_B,
+			      const uint64_t addr_first, const uint64_t addr_last, PtLutDiff& diff ) {
+
+  for (uint64_t addr = addr_first; addr < addr_last; addr++) {
+    if ( lut_A.Unreachable( int(addr) ) || lut_B.Unreachable( int(addr) ) ) continue;
+    int word_A = lut_A.LookupWord( int(addr) );
+    int word_B = lut_B.LookupWord( int(addr) );
+    if (word_A != word_B)
+      diff.Add( int(addr), word_A, word_B );
+    diff.n_compared += 1;
+  }
+
+} // End function: static void CompareAddresses()
+
+
+bool PtLutDiff::Compare( const PtLutFile& lut_A, const PtLutFile& lut_B ) {
+
+  Reset();
+  if ( !lut_A.IsOpen() || !lut_B.IsOpen() ) {
+    std::cout << "ERROR: PtLutDiff::Compare needs two open LUT files" << std::endl;
+    return false;
+  }
+  if ( lut_A.header.layout != lut_B.header.layout || lut_A.header.lsb_shift != lut_B.header.lsb_shift ) {
+    std::cout << "ERROR: " << lut_A.file_name << " and " << lut_B.file_name
+	      << " have different address layouts or pT LSBs, cannot compare word by word" << std::endl;
+    return false;
+  }
+
+  const bool packed = ( lut_A.SameEntries( lut_B ) &&
+			lut_A.header.entry_bits == lut_B.header.entry_bits );
+
+  uint64_t first = std::min( lut_A.header.addr_min, lut_B.header.addr_min );
+  uint64_t last  = std::max( lut_A.header.addr_min + lut_A.header.n_addresses,
+			     lut_B.header.addr_min + lut_B.header.n_addresses );
+  if (packed) {
+    first = 0;
+    last  = lut_A.header.n_entries;
+  }
+  lut_A.Advise(true);
+  lut_B.Advise(true);
+
+  // Thread boundaries on multiples of 64 entries, which always start on a new packed word
+  const int nTh = std::max(n_threads, 1);
+  const uint64_t chunk = (((last - first) / nTh + 63) / 64) * 64;
+  std::vector<PtLutDiff> diffs( nTh, PtLutDiff(n_top, 1) );
+  std::vector<std::thread> threads;
+  for (int iTh = 0; iTh < nTh; iTh++) {
+    uint64_t lo = std::min( last, first + iTh * chunk );
+    uint64_t hi = std::min( last, first + (iTh + 1) * chunk );
+    if (packed)
+      threads.push_back( std::thread( ComparePacked,    std::cref(lut_A), std::cref(lut_B), lo, hi, std::ref(diffs.at(iTh)) ) );
+    else
+      threads.push_back( std::thread( CompareAddresses, std::cref(lut_A), std::cref(lut_B), lo, hi, std::ref(diffs.at(iTh)) ) );
+  }
+  for (int iTh = 0; iTh < nTh; iTh++) {
+    threads.at(iTh).join();
+    Merge( diffs.at(iTh) );
+  }
+
+  lut_A.Advise(false);
+  lut_B.Advise(false);
+
+  std::sort( top.begin(), top.end(), PtLutShiftGreater );
+  return true;
+} // End function: bool PtLutDiff::Compare()
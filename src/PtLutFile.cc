@@ -0,0 +1,267 @@
+
+#include "../interface/PtLutFile.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <cstddef>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+bool PtLutFile::Open( const std::string _file_name ) {
+
+  Close();
+  file_name = _file_name;
+
+  int fd = open( file_name.c_str(), O_RDONLY );
+  if (fd < 0) {
+    std::cout << "ERROR: could not open pT LUT file " << file_name << std::endl;
+    return false;
+  }
+
+  struct stat st;
+  if ( fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(PtLutHeader) ) {
+    std::cout << "ERROR: pT LUT file " << file_name << " is too short to hold a header" << std::endl;
+    close(fd);
+    return false;
+  }
+
+  map_size = st.st_size;
+  map_addr = mmap( 0, map_size, PROT_READ, MAP_SHARED, fd, 0 );
+  close(fd);  // The mapping stays valid after the descriptor is closed
+  if (map_addr == MAP_FAILED) {
+    std::cout << "ERROR: could not mmap pT LUT file " << file_name << std::endl;
+    map_addr = 0;
+    map_size = 0;
+    return false;
+  }
+
+  // A version 1 header ends at the description: the fields after it describe the dense layout
+  const size_t v1_size = offsetof(PtLutHeader, n_addresses);
+  memset( &header, 0, sizeof(PtLutHeader) );
+  memcpy( &header, map_addr, v1_size );
+  if (header.version == PT_LUT_VERSION && header.header_size == sizeof(PtLutHeader))
+    memcpy( &header, map_addr, sizeof(PtLutHeader) );
+  else if (header.version == 1 && header.header_size == v1_size)
+    header.n_addresses = header.n_entries;
+
+  // Check the header before trusting any offset in it
+  bool valid = true;
+  if ( memcmp(header.magic, PT_LUT_MAGIC, sizeof(PT_LUT_MAGIC)) != 0 ) {
+    std::cout << "ERROR: " << file_name << " is not a pT LUT file (bad magic)" << std::endl;
+    valid = false;
+  } else if ( !(header.version == PT_LUT_VERSION && header.header_size == sizeof(PtLutHeader)) &&
+	      !(header.version == 1 && header.header_size == v1_size) ) {
+    std::cout << "ERROR: " << file_name << " has LUT format version " << header.version
+	      << ", this code reads versions 1 - " << PT_LUT_VERSION << std::endl;
+    valid = false;
+  } else if ( header.entry_bits < 1 || header.entry_bits > 16 || header.pt_encoding != PtLutHeader::kPtLinear ||
+	      header.data_offset % sizeof(uint64_t) != 0 ||
+	      header.data_size < ((header.n_entries * header.entry_bits + 63) / 64 + 1) * sizeof(uint64_t) ||
+	      header.data_offset + header.data_size > map_size ) {
+    std::cout << "ERROR: " << file_name << " has an inconsistent LUT header" << std::endl;
+    valid = false;
+  } else if ( header.remap_size == 0 ? header.n_addresses != header.n_entries :
+	      ( header.range_bits > 30 || header.remap_offset % sizeof(int32_t) != 0 ||
+		header.remap_offset + header.remap_size * sizeof(int32_t) > map_size ||
+		(uint64_t(header.remap_size) << header.range_bits) != header.n_addresses ) ) {
+    std::cout << "ERROR: " << file_name << " has an inconsistent remap table" << std::endl;
+    valid = false;
+  }
+
+  // Each stored range has exactly one rank, and the ranks fill the entries
+  if (valid && header.remap_size > 0) {
+    ranks = reinterpret_cast<const int32_t*>( static_cast<const char*>(map_addr) + header.remap_offset );
+    uint64_t n_ranges = 0;
+    for (uint32_t i = 0; i < header.remap_size; i++)
+      n_ranges += (ranks[i] >= 0);
+    ranges.assign( n_ranges, header.remap_size );
+    for (uint32_t i = 0; i < header.remap_size && valid; i++) {
+      if (ranks[i] < 0) continue;
+      if (uint64_t(ranks[i]) >= n_ranges || ranges.at(ranks[i]) != header.remap_size) valid = false;
+      else ranges.at(ranks[i]) = i;
+    }
+    if ( !valid || (n_ranges << header.range_bits) != header.n_entries ) {
+      std::cout << "ERROR: " << file_name << " has an inconsistent remap table" << std::endl;
+      valid = false;
+    }
+  }
+  if (!valid) {
+    Close();
+    return false;
+  }
+
+  data = reinterpret_cast<const uint64_t*>( static_cast<const char*>(map_addr) + header.data_offset );
+  mask = (uint64_t(1) << header.entry_bits) - 1;
+  Advise(false);
+
+  std::cout << "Mapped pT LUT " << file_name << ": mode " << header.mode << ", " << header.n_entries
+	    << " entries x " << header.entry_bits << " bits from address " << header.addr_min << std::endl;
+  if (ranks != 0)
+    std::cout << "  * Sparse: " << ranges.size() << " of " << header.remap_size << " ranges of 2^" << header.range_bits
+	      << " addresses stored, " << header.n_entries << " of " << header.n_addresses << " addresses" << std::endl;
+  if (header.description[0] != '\0')
+    std::cout << "  * " << header.description << std::endl;
+  return true;
+} // End function: bool PtLutFile::Open()
+
+
+void PtLutFile::Close() {
+
+  if (map_addr != 0)
+    munmap( map_addr, map_size );
+  data     = 0;
+  ranks    = 0;
+  ranges.clear();
+  map_addr = 0;
+  map_size = 0;
+  mask     = 0;
+
+} // End function: void PtLutFile::Close()
+
+
+void PtLutFile::Advise( const bool sequential ) const {
+
+  if (map_addr == 0) return;
+  // Track addresses are scattered over the whole table, so by default don't read ahead
+  madvise( map_addr, map_size, (sequential ? MADV_SEQUENTIAL : MADV_RANDOM) );
+
+} // End function: void PtLutFile::Advise()
+
+
+void PtLutFile::LookupWords( const int* addresses, const int n, int* words ) const {
+
+  // Each lookup is a likely cache (and TLB) miss: keep several in flight
+  const int AHEAD = 16;
+  for (int i = 0; i < n && i < AHEAD; i++) {
+    int64_t idx = EntryIndex( addresses[i] );
+    if (idx >= 0) __builtin_prefetch( data + ((idx * header.entry_bits) >> 6) );
+  }
+
+  for (int i = 0; i < n; i++) {
+    if (i + AHEAD < n) {
+      int64_t idx = EntryIndex( addresses[i + AHEAD] );
+      if (idx >= 0) __builtin_prefetch( data + ((idx * header.entry_bits) >> 6) );
+    }
+    words[i] = LookupWord( addresses[i] );
+  }
+
+} // End function: void PtLutFile::LookupWords()
+
+
+void PtLutFile::Lookup( const int* addresses, const int n, double* pts ) const {
+
+  const int CHUNK = 256;
+  int words[CHUNK];
+  for (int i = 0; i < n; i += CHUNK) {
+    int nChunk = (n - i < CHUNK ? n - i : CHUNK);
+    LookupWords( addresses + i, nChunk, words );
+    for (int j = 0; j < nChunk; j++)
+      pts[i + j] = PtFromWord( words[j] );
+  }
+
+} // End function: void PtLutFile::Lookup()
+
+
+bool PtLutFile::SameEntries( const PtLutFile& other ) const {
+
+  if ( header.addr_min    != other.header.addr_min  || header.n_addresses != other.header.n_addresses ||
+       header.n_entries   != other.header.n_entries || header.remap_size  != other.header.remap_size ||
+       header.range_bits  != other.header.range_bits ) return false;
+  return ( ranks == 0 || memcmp( ranks, other.ranks, header.remap_size * sizeof(int32_t) ) == 0 );
+
+} // End function: bool PtLutFile::SameEntries()
+
+
+bool PtLutWriter::Create( const std::string _file_name, const PtLutHeader& _header, const std::vector<int>& _ranks ) {
+
+  Close();
+  file_name = _file_name;
+  header    = _header;
+  ranks.assign( _ranks.begin(), _ranks.end() );
+
+  if (ranks.empty()) {
+    header.n_addresses = header.n_entries;
+    header.remap_size  = 0;
+    header.range_bits  = 0;
+  } else {
+    assert( header.range_bits <= 30 && (uint64_t(ranks.size()) << header.range_bits) == header.n_addresses );
+    uint64_t n_ranges = 0;
+    for (size_t i = 0; i < ranks.size(); i++)
+      n_ranges += (ranks.at(i) >= 0);
+    header.n_entries  = n_ranges << header.range_bits;
+    header.remap_size = ranks.size();
+  }
+
+  assert( header.entry_bits >= 1 && header.entry_bits <= 16 );
+  assert( header.n_entries > 0 );
+
+  memcpy( header.magic, PT_LUT_MAGIC, sizeof(PT_LUT_MAGIC) );
+  header.version     = PT_LUT_VERSION;
+  header.header_size = sizeof(PtLutHeader);
+  header.layout      = PtLutHeader::kLayout2017;
+  header.pt_encoding = PtLutHeader::kPtLinear;
+  header.description[sizeof(header.description) - 1] = '\0';
+
+  // Remap table right after the header; page-aligned data, with one spare word so that readers can always load two words per entry
+  const uint64_t page = sysconf(_SC_PAGESIZE);
+  header.remap_offset = (ranks.empty() ? 0 : ((sizeof(PtLutHeader) + 7) / 8) * 8);
+  const uint64_t head_end = (ranks.empty() ? sizeof(PtLutHeader) : header.remap_offset + ranks.size() * sizeof(int32_t));
+  header.data_offset = ((head_end + page - 1) / page) * page;
+  header.data_size   = ((header.n_entries * header.entry_bits + 63) / 64 + 1) * sizeof(uint64_t);
+  map_size = header.data_offset + header.data_size;
+  mask     = (uint64_t(1) << header.entry_bits) - 1;
+
+  std::string tmp_name = file_name + ".tmp";
+  int fd = open( tmp_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+  if (fd < 0) {
+    std::cout << "ERROR: could not create pT LUT file " << tmp_name << std::endl;
+    return false;
+  }
+  // Sparse file: untouched pages read back as zero without taking disk space
+  if ( ftruncate(fd, map_size) != 0 ) {
+    std::cout << "ERROR: could not resize pT LUT file " << tmp_name << " to " << map_size << " bytes" << std::endl;
+    close(fd);
+    return false;
+  }
+  map_addr = mmap( 0, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  close(fd);
+  if (map_addr == MAP_FAILED) {
+    std::cout << "ERROR: could not mmap pT LUT file " << tmp_name << std::endl;
+    map_addr = 0;
+    map_size = 0;
+    return false;
+  }
+
+  memcpy( map_addr, &header, sizeof(PtLutHeader) );
+  if (!ranks.empty())
+    memcpy( static_cast<char*>(map_addr) + header.remap_offset, ranks.data(), ranks.size() * sizeof(int32_t) );
+  data = reinterpret_cast<uint64_t*>( static_cast<char*>(map_addr) + header.data_offset );
+  return true;
+} // End function: bool PtLutWriter::Create()
+
+
+bool PtLutWriter::Close() {
+
+  if (map_addr == 0) return false;
+
+  bool ok = ( msync(map_addr, map_size, MS_SYNC) == 0 );
+  munmap( map_addr, map_size );
+  data     = 0;
+  map_addr = 0;
+  map_size = 0;
+
+  std::string tmp_name = file_name + ".tmp";
+  if ( ok && rename(tmp_name.c_str(), file_name.c_str()) == 0 ) {
+    std::cout << "Wrote pT LUT " << file_name << " with " << header.n_entries << " entries";
+    if (!ranks.empty()) std::cout << " (sparse, of " << header.n_addresses << " addresses)";
+    std::cout << std::endl;
+    return true;
+  }
+  std::cout << "ERROR: could not write pT LUT file " << file_name << std::endl;
+  return false;
+} // End function: bool PtLutWriter::Close()
@@ -0,0 +1,97 @@
+
+#include "../interface/PtLutReach.h"
+#include "../interface/PtLutAddress.h"  // PtLutAddressRange
+#include "../interface/PtAssigner.h"    // PtAssigner::CalcVars: the address chain of the drivers
+
+#include <iostream>
+#include <cstring>
+#include <cassert>
+
+
+// Width of the fields below the upper ones in the CalcPtLutAddress() layouts (see interface/PtLutAddress.h):
+//   4-station: dPhiAB dPhiBC dPhiCD sPhiBC sPhiCD dTheta(2) frA     below mode15_8b
+//   3-station: dPhiAB dPhiBC sPhiBC dTheta(3) frA [frB]             below clctA, rpc_2b and theta
+//   2-station: dPhiAB dTheta(3) frA frB                             below clctA, clctB and theta
+static int PLRRangeBits( const int mode, const int nHits ) {
+  if (nHits == 4) return 7 + 5 + 4 + 1 + 1 + 2 + 1;
+  if (nHits == 3) return 7 + 5 + 1 + 3 + 1 + (mode != 7 ? 1 : 0);
+  return 7 + 3 + 1 + 1;
+}
+
+
+bool PtLutReach::Build( const int _mode ) {
+
+  *this = PtLutReach();
+  if (_mode < 3 || _mode > 15 || _mode == 4 || _mode == 8) {
+    std::cout << "ERROR: PtLutReach::Build needs a 2-, 3- or 4-station mode, not " << _mode << std::endl;
+    return false;
+  }
+  mode = _mode;
+  PtLutAddressRange( mode, addr_min, n_addr );
+
+  int st[4] = {-1, -1, -1, -1};  // Stations in the track, in order: A, B, C, D
+  int nHits = 0;
+  for (int iSt = 0; iSt < 4; iSt++)
+    if ((mode >> (3 - iSt)) & 1) st[nHits++] = iSt;
+  range_bits = PLRRangeBits( mode, nHits );
+
+  // Only the bend of station A (and B in 2-station modes) enters the upper fields; the other patterns are fixed
+  const int n_pat_B = (nHits == 2 ? 9 : 1);
+  const int n_ring  = (mode >= 8 ? 3 : 1);
+  std::vector<bool> seen( n_addr >> range_bits, false );
+
+  PtAssignTrack trk;
+  memset( &trk, 0, sizeof(trk) );
+  trk.mode = mode;
+  PtLutAddressVars vars;
+  int dPhSign;
+
+  for (int th = 5; th < 128; th++) {                      // getTheta range
+    for (int ring = 1; ring <= n_ring; ring++) {          // ME1/1, ME1/2, ME1/3
+      for (int rpc = 0; rpc < (1 << nHits); rpc++) {      // Before CalcRPCs masking
+	for (int pat_A = 2; pat_A <= 10; pat_A++) {       // CSC CLCT patterns; RPC hits have pattern 0
+	  if ((rpc & 1) && pat_A > 2) continue;
+	  for (int pat_B = 2; pat_B < 2 + n_pat_B; pat_B++) {
+	    if ((rpc & 2) && pat_B > 2) continue;
+	    for (int endcap = -1; endcap <= 1; endcap += 2) {
+	      for (int sign = -1; sign <= 1; sign += 2) {   // dPhSign, from the first dPhi
+
+		trk.endcap = endcap;
+		for (int i = 0; i < nHits; i++) {
+		  const int pat = (i == 0 ? pat_A : (i == 1 && n_pat_B > 1 ? pat_B : 10));
+		  trk.phi    [st[i]] = 2048 + (i == 0 ? 0 : sign * 32);
+		  trk.theta  [st[i]] = th;
+		  trk.isRPC  [st[i]] = (rpc >> i) & 1;
+		  trk.pattern[st[i]] = (trk.isRPC[st[i]] ? 0 : pat);
+		  trk.ring   [st[i]] = (st[i] == 0 ? ring : 1);
+		}
+		const int address = PtAssigner::CalcVars( trk, vars, dPhSign );
+		assert( address >= addr_min && address - addr_min < n_addr );
+		seen.at( (address - addr_min) >> range_bits ) = true;
+
+	      } // End loop: for (int sign = -1; sign <= 1; sign += 2)
+	    }
+	  }
+	}
+      }
+    }
+  } // End loop: for (int th = 5; th < 128; th++)
+
+  ranks.assign( seen.size(), -1 );
+  for (int i = 0; i < int(seen.size()); i++) {
+    if (!seen.at(i)) continue;
+    ranks.at(i) = int(ranges.size());
+    ranges.push_back( i );
+  }
+  return true;
+
+} // End function: bool PtLutReach::Build()
+
+
+void PtLutReach::Print() const {
+
+  std::cout << "Mode " << mode << ": " << ranges.size() << " of " << ranks.size() << " upper-field values reachable, "
+	    << NReachable() << " of " << n_addr << " addresses ("
+	    << (n_addr > 0 ? 100.0 * NReachable() / n_addr : 0.) << "%)" << std::endl;
+
+} // End function: void PtLutReach::Print()
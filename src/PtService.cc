@@ -0,0 +1,254 @@
+
+#include "../interface/PtService.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+const uint32_t PtServer::MAX_BATCH;
+
+
+// Read exactly size bytes; 1 on success, 0 on end-of-file before the first byte, -1 on error or a truncated message
+static int PTSRead( const int fd, void* buf, const size_t size ) {
+  size_t done = 0;
+  while (done < size) {
+    const ssize_t n = read( fd, (char*) buf + done, size - done );
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return (n == 0 && done == 0 ? 0 : -1);
+    done += n;
+  }
+  return 1;
+}
+
+// Write exactly size bytes, without SIGPIPE if the peer has gone
+static bool PTSWrite( const int fd, const void* buf, const size_t size ) {
+  size_t done = 0;
+  while (done < size) {
+    const ssize_t n = send( fd, (const char*) buf + done, size - done, MSG_NOSIGNAL );
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    done += n;
+  }
+  return true;
+}
+
+// Checks of the inputs which PtAssigner::CalcVars() asserts on, or which could overflow the dPhi
+static bool PTSValidTrack( const PtAssignTrack& trk ) {
+  const int mode = trk.mode;
+  if (mode < 3 || mode > 15 || mode == 4 || mode == 8) return false;  // dPhSign needs two stations
+  if (trk.endcap != 1 && trk.endcap != -1) return false;
+  for (int iSt = 0; iSt < 4; iSt++) {
+    if ( ((mode >> (3 - iSt)) & 1) == 0 ) continue;
+    if (trk.phi    [iSt] < 0 || trk.phi    [iSt] >= (1 << 13)) return false;  // 13-bit phi_int
+    if (trk.theta  [iSt] < 0 || trk.theta  [iSt] >= (1 << 7))  return false;  // 7-bit theta_int
+    if (trk.pattern[iSt] < 0 || trk.pattern[iSt] > 10)         return false;  // getCLCT()
+    if (trk.FR     [iSt] != 0 && trk.FR     [iSt] != 1)        return false;  // BDT inputs take FR as sent
+    if (trk.isRPC  [iSt] != 0 && trk.isRPC  [iSt] != 1)        return false;
+  }
+  if ( (mode & 8) && (trk.ring[0] < 1 || trk.ring[0] > 3) )    return false;  // St1_ring2
+  // Track theta from the first of stations 2, 3, 4: 5 - 127 is the range of getTheta()
+  const int iTh = ( (mode & 4) ? 1 : ((mode & 2) ? 2 : 3) );
+  return (trk.theta[iTh] >= 5);
+}
+
+static bool PTSAddress( const std::string& socket_path, sockaddr_un& addr ) {
+  memset( &addr, 0, sizeof(addr) );
+  addr.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(addr.sun_path)) {
+    std::cout << "ERROR: socket path " << socket_path << " is longer than " << sizeof(addr.sun_path) - 1 << " characters" << std::endl;
+    return false;
+  }
+  strncpy( addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1 );
+  return true;
+}
+
+
+PtServer::~PtServer() {
+
+  Stop();
+
+} // End destructor PtServer::~PtServer()
+
+
+bool PtServer::Run() {
+
+  sockaddr_un addr;
+  if ( !PTSAddress( socket_path, addr ) ) return false;
+
+  // A socket file nobody answers on is left over from a previous server: replace it
+  const int probe = socket( AF_UNIX, SOCK_STREAM, 0 );
+  if (probe >= 0 && connect( probe, (sockaddr*) &addr, sizeof(addr) ) == 0) {
+    std::cout << "ERROR: a server is already running on " << socket_path << std::endl;
+    close( probe );
+    return false;
+  }
+  if (probe >= 0) close( probe );
+  unlink( socket_path.c_str() );
+
+  listen_fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+  if ( listen_fd < 0 ||
+       bind( listen_fd, (sockaddr*) &addr, sizeof(addr) ) != 0 ||
+       listen( listen_fd, 64 ) != 0 ) {
+    std::cout << "ERROR: could not listen on " << socket_path << ": " << strerror(errno) << std::endl;
+    if (listen_fd >= 0) close( listen_fd );
+    listen_fd = -1;
+    return false;
+  }
+  std::cout << "Serving pT assignment on " << socket_path << std::endl;
+
+  while (!stop) {
+    const int fd = accept( listen_fd, 0, 0 );
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      break;  // Stop() shut the socket down
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    // Join the threads of clients that have gone (fd set to -1 at the end of Serve), so they do not pile up
+    for (UInt_t i = 0; i < threads.size(); ) {
+      if (client_fds.at(i) >= 0) { i++; continue; }
+      threads.at(i).join();
+      threads.erase( threads.begin() + i );
+      client_fds.erase( client_fds.begin() + i );
+    }
+    client_fds.push_back( fd );
+    threads.push_back( std::thread( &PtServer::Serve, this, fd ) );
+  }
+
+  // Let every client finish the batch it is in, then wait for its thread
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (UInt_t i = 0; i < client_fds.size(); i++)
+      shutdown( client_fds.at(i), SHUT_RD );
+  }
+  for (UInt_t i = 0; i < threads.size(); i++)
+    threads.at(i).join();
+  threads.clear();
+  client_fds.clear();
+
+  close( listen_fd );
+  listen_fd = -1;
+  unlink( socket_path.c_str() );
+  std::cout << "Stopped serving on " << socket_path << " after " << n_batches << " batches, " << n_tracks << " tracks" << std::endl;
+  return true;
+
+} // End function: bool PtServer::Run()
+
+
+void PtServer::Stop() {
+
+  stop = true;
+  if (listen_fd >= 0)
+    shutdown( listen_fd, SHUT_RDWR );
+
+} // End function: void PtServer::Stop()
+
+
+void PtServer::Serve( const int fd ) {
+
+  std::vector<PtAssignTrack>  trks;
+  std::vector<PtAssignResult> results;
+
+  while (true) {
+    PtServiceHeader head;
+    if ( PTSRead( fd, &head, sizeof(head) ) <= 0 ) break;
+
+    PtServiceHeader resp;
+    resp.magic   = PT_SERVICE_MAGIC;
+    resp.version = PT_SERVICE_VERSION;
+    resp.n       = head.n;
+    resp.status  = PtServiceHeader::kOK;
+    if (head.magic != PT_SERVICE_MAGIC || head.version != PT_SERVICE_VERSION) resp.status = PtServiceHeader::kBadHeader;
+    else if (head.n > MAX_BATCH)                                               resp.status = PtServiceHeader::kTooLarge;
+    if (resp.status != PtServiceHeader::kOK) {
+      PTSWrite( fd, &resp, sizeof(resp) );
+      break;  // The rest of the stream cannot be parsed
+    }
+
+    trks.resize( head.n );
+    if ( PTSRead( fd, trks.data(), head.n * sizeof(PtAssignTrack) ) <= 0 ) break;
+    // Tracks the variable code would assert on are answered as tracks without a mode (address -1, pt_word -1)
+    for (UInt_t i = 0; i < head.n; i++) {
+      if ( PTSValidTrack( trks[i] ) ) continue;
+      trks[i].mode = 0;
+      resp.status  = PtServiceHeader::kBadTrack;
+    }
+    assigner.Assign( trks, results );
+    if ( !PTSWrite( fd, &resp, sizeof(resp) ) ||
+	 !PTSWrite( fd, results.data(), head.n * sizeof(PtAssignResult) ) ) break;
+    n_batches += 1;
+    n_tracks  += head.n;
+  }
+
+  // The fd stays in client_fds until Run() returns, so it is closed under the lock to keep shutdown() off a reused fd
+  std::lock_guard<std::mutex> lock(mtx);
+  for (UInt_t i = 0; i < client_fds.size(); i++)
+    if (client_fds.at(i) == fd) client_fds.at(i) = -1;
+  close( fd );
+
+} // End function: void PtServer::Serve()
+
+
+bool PtClient::Connect( const std::string socket_path ) {
+
+  Close();
+  sockaddr_un addr;
+  if ( !PTSAddress( socket_path, addr ) ) return false;
+  fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+  if ( fd < 0 || connect( fd, (sockaddr*) &addr, sizeof(addr) ) != 0 ) {
+    std::cout << "ERROR: could not connect to " << socket_path << ": " << strerror(errno) << std::endl;
+    Close();
+    return false;
+  }
+  return true;
+
+} // End function: bool PtClient::Connect()
+
+
+void PtClient::Close() {
+
+  if (fd >= 0) close( fd );
+  fd = -1;
+
+} // End function: void PtClient::Close()
+
+
+bool PtClient::Assign( const std::vector<PtAssignTrack>& trks, std::vector<PtAssignResult>& results ) {
+
+  results.resize( trks.size() );
+  if (fd < 0) return false;
+
+  for (size_t first = 0; first < trks.size(); first += PtServer::MAX_BATCH) {
+    PtServiceHeader head;
+    head.magic   = PT_SERVICE_MAGIC;
+    head.version = PT_SERVICE_VERSION;
+    head.n       = std::min( size_t(PtServer::MAX_BATCH), trks.size() - first );
+    head.status  = PtServiceHeader::kOK;
+    PtServiceHeader resp;
+    if ( !PTSWrite( fd, &head, sizeof(head) ) ||
+	 !PTSWrite( fd, trks.data() + first, head.n * sizeof(PtAssignTrack) ) ||
+	 PTSRead( fd, &resp, sizeof(resp) ) <= 0 ) {
+      std::cout << "ERROR: lost the connection to the pT server" << std::endl;
+      Close();
+      return false;
+    }
+    if ( (resp.status != PtServiceHeader::kOK && resp.status != PtServiceHeader::kBadTrack) || resp.n != head.n ) {
+      std::cout << "ERROR: pT server rejected a batch of " << head.n << " tracks, status " << resp.status << std::endl;
+      Close();
+      return false;
+    }
+    if ( PTSRead( fd, results.data() + first, head.n * sizeof(PtAssignResult) ) <= 0 ) {
+      std::cout << "ERROR: lost the connection to the pT server" << std::endl;
+      Close();
+      return false;
+    }
+    if (resp.status == PtServiceHeader::kBadTrack)
+      std::cout << "WARNING: pT server rejected invalid tracks in a batch of " << head.n << ", returned with address -1" << std::endl;
+  }
+  return true;
+
+} // End function: bool PtClient::Assign()
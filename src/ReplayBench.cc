@@ -0,0 +1,337 @@
+
+#include "../interface/ReplayBench.h"
+#include "../interface/TrackBuilder.h"    // BuildTracksAllModes
+#include "../interface/NTupleGenerator.h"
+#include "../interface/PtService.h"       // PtClient
+
+#include "TChain.h"
+#include "TBranch.h"
+#include "TLeaf.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cassert>
+
+const int LatencyHist::SUB_BITS;
+const int LatencyHist::N_BINS;
+const int ReplayBench::N_MULT;
+
+
+uint64_t LatencyHist::BinLow( const int bin ) {
+
+  if (bin < (1 << SUB_BITS)) return uint64_t(bin);
+  const int e = (bin >> SUB_BITS) + SUB_BITS - 1;
+  return (uint64_t(1 << SUB_BITS) + (bin & ((1 << SUB_BITS) - 1))) << (e - SUB_BITS);
+
+} // End function: uint64_t LatencyHist::BinLow()
+
+
+uint64_t LatencyHist::BinWidth( const int bin ) {
+
+  if (bin < (2 << SUB_BITS)) return 1;
+  return uint64_t(1) << ((bin >> SUB_BITS) - 1);
+
+} // End function: uint64_t LatencyHist::BinWidth()
+
+
+void LatencyHist::Add( const LatencyHist& other ) {
+
+  for (int i = 0; i < N_BINS; i++)
+    counts[i] += other.counts[i];
+  n   += other.n;
+  sum += other.sum;
+  if (other.max > max) max = other.max;
+
+} // End function: void LatencyHist::Add()
+
+
+void LatencyHist::Reset() {
+
+  std::fill( counts.begin(), counts.end(), 0 );
+  n = 0; sum = 0; max = 0;
+
+} // End function: void LatencyHist::Reset()
+
+
+double LatencyHist::Percentile( const double q ) const {
+
+  if (n == 0) return 0.;
+  // Rank of the event at quantile q, counting from 1
+  const uint64_t rank = std::max( uint64_t(1), uint64_t( ceil( q * n ) ) );
+  uint64_t cum = 0;
+  for (int i = 0; i < N_BINS; i++) {
+    cum += counts[i];
+    if (cum >= rank)
+      return std::min( double(max), BinLow(i) + 0.5 * (BinWidth(i) - 1) );
+  }
+  return double(max);
+
+} // End function: double LatencyHist::Percentile()
+
+
+Long64_t ReplayBench::LoadNTuples( const std::vector<TString>& file_names, const Long64_t max_evt ) {
+
+  TChain chain("ntuple/tree");
+  for (UInt_t i = 0; i < file_names.size(); i++)
+    chain.Add( file_names.at(i) );
+
+  const Long64_t nEvt0 = NEvents();
+  for (Long64_t iEvt = 0; iEvt < max_evt || max_evt < 0; iEvt++) {
+    if ( chain.GetEntry(iEvt) <= 0 ) break;
+    TBranch* hit_br = chain.GetBranch("hit");  // Changes with every file of the chain
+    const int nHits = (hit_br->GetLeaf("nHits"))->GetValue();
+    for (int iHit = 0; iHit < nHits; iHit++) {
+      Hit hit;
+      hit.endcap       = (hit_br->GetLeaf("endcap"))      ->GetValue(iHit);
+      hit.sector_index = (hit_br->GetLeaf("sector_index"))->GetValue(iHit);
+      hit.station      = (hit_br->GetLeaf("station"))     ->GetValue(iHit);
+      hit.ring         = (hit_br->GetLeaf("ring"))        ->GetValue(iHit);
+      hit.chamber      = (hit_br->GetLeaf("chamber"))     ->GetValue(iHit);
+      hit.phi_int      = (hit_br->GetLeaf("phi_int"))     ->GetValue(iHit);
+      hit.theta_int    = (hit_br->GetLeaf("theta_int"))   ->GetValue(iHit);
+      hit.pattern      = (hit_br->GetLeaf("pattern"))     ->GetValue(iHit);
+      hit.isRPC        = (hit_br->GetLeaf("isRPC"))       ->GetValue(iHit);
+      if (hit.sector_index < 1 || hit.sector_index > 12 || hit.station < 1 || hit.station > 4) continue;
+      hits.push_back( hit );
+    }
+    evt_first.push_back( hits.size() );
+  }
+
+  const Long64_t nAdded = NEvents() - nEvt0;
+  std::stringstream ss;
+  ss << (source.Length() > 0 ? "+" : "") << "ntuple:" << nAdded << ":files" << file_names.size();
+  source += ss.str();
+  std::cout << "Loaded " << nAdded << " events from " << file_names.size() << " files" << std::endl;
+  return nAdded;
+
+} // End function: Long64_t ReplayBench::LoadNTuples()
+
+
+Long64_t ReplayBench::LoadSynthetic( NTupleGenerator& gen, const Long64_t n_evt, const bool zero_bias, const ULong64_t seed ) {
+
+  const NTupleGenerator::EMTFHitBranch& br = gen.Hits();
+  gen.Seed( seed );
+  for (Long64_t iEvt = 0; iEvt < n_evt; iEvt++) {
+    gen.Next( zero_bias );
+    for (int iHit = 0; iHit < br.nHits; iHit++) {
+      Hit hit;
+      hit.endcap       = br.endcap      [iHit];
+      hit.sector_index = br.sector_index[iHit];
+      hit.station      = br.station     [iHit];
+      hit.ring         = br.ring        [iHit];
+      hit.chamber      = br.chamber     [iHit];
+      hit.phi_int      = br.phi_int     [iHit];
+      hit.theta_int    = br.theta_int   [iHit];
+      hit.pattern      = br.pattern     [iHit];
+      hit.isRPC        = br.isRPC       [iHit];
+      hits.push_back( hit );
+    }
+    evt_first.push_back( hits.size() );
+  }
+
+  std::stringstream ss;
+  ss << (source.Length() > 0 ? "+" : "") << (zero_bias ? "genZB:" : "genMC:") << n_evt << ":seed" << seed;
+  source += ss.str();
+  std::cout << "Generated " << n_evt << (zero_bias ? " ZeroBias" : " MC") << " events with seed " << seed << std::endl;
+  return n_evt;
+
+} // End function: Long64_t ReplayBench::LoadSynthetic()
+
+
+int ReplayBench::MultBin( const int nHits ) {
+
+  int iMult = 0;
+  while (iMult < N_MULT - 1 && nHits >= (1 << iMult))
+    iMult += 1;
+  return iMult;
+
+} // End function: int ReplayBench::MultBin()
+
+
+TString ReplayBench::MultLabel( const int iMult ) {
+
+  if (iMult == 0)          return "0";
+  if (iMult == 1)          return "1";
+  if (iMult == N_MULT - 1) return Form( ">=%d", 1 << (iMult - 1) );
+  return Form( "%d-%d", 1 << (iMult - 1), (1 << iMult) - 1 );
+
+} // End function: TString ReplayBench::MultLabel()
+
+
+int ReplayBench::ProcessEvent( const Long64_t iEvt, uint64_t& hash, Long64_t& nTrk ) {
+
+  // Hit collection by sector and station, as in the drivers
+  const Hit* evt_hits = hits.data() + evt_first[iEvt];
+  const int  nHits    = int( evt_first[iEvt + 1] - evt_first[iEvt] );
+  for (int iSc = 0; iSc < 12; iSc++) {
+    for (int iSt = 0; iSt < 4; iSt++) {
+      id[iSc][iSt].clear();
+      ph[iSc][iSt].clear();
+      th[iSc][iSt].clear();
+      dt[iSc][iSt].clear();
+    }
+  }
+  for (int iHit = 0; iHit < nHits; iHit++) {
+    const Hit& hit = evt_hits[iHit];
+    const int iSc = hit.sector_index - 1;
+    const int iSt = hit.station - 1;
+    id[iSc][iSt].push_back( iHit );
+    ph[iSc][iSt].push_back( hit.phi_int );
+    th[iSc][iSt].push_back( hit.theta_int );
+    dt[iSc][iSt].push_back( hit.isRPC ? 2 : 1 );
+  }
+
+  BuildTracksAllModes( trks_hits, trks_modes, id, ph, th, dt, max_RPC, min_CSC, max_dPh, max_dTh );
+
+  // One batch with the tracks of every mode that has a LUT or BDT
+  int best_mode = 0;
+  batch.clear();
+  for (int mode = 15; mode >= 3; mode--) {
+    if (trks_hits[mode].empty()) continue;
+    if (best_mode == 0) best_mode = mode;
+    if (!client && !assigner.HasMode(mode)) continue;
+
+    for (UInt_t iTrk = 0; iTrk < trks_hits[mode].size(); iTrk++) {
+      const std::array<int, 4>& trk_hits = trks_hits[mode][iTrk];
+      PtAssignTrack trk;
+      trk.mode   = mode;
+      trk.endcap = 0;
+      for (int iSt = 0; iSt < 4; iSt++) {
+	if (trk_hits[iSt] < 0) {
+	  trk.phi[iSt] = -99; trk.theta[iSt] = -99; trk.pattern[iSt] = -99;
+	  trk.ring[iSt] = -99; trk.FR[iSt] = -99; trk.isRPC[iSt] = -99;
+	  continue;
+	}
+	const Hit& hit = evt_hits[trk_hits[iSt]];
+	trk.phi    [iSt] = hit.phi_int;
+	trk.theta  [iSt] = hit.theta_int;
+	trk.pattern[iSt] = hit.pattern;
+	trk.ring   [iSt] = hit.ring;
+	trk.isRPC  [iSt] = hit.isRPC;
+	// FR bit from the chamber number, as in firmware (also for RPC hits): odd chambers are bolted
+	// to the iron, which faces forward in stations 1 & 2, backwards in 3 & 4; ME1/3 does not overlap
+	trk.FR     [iSt] = (iSt < 2 ? (hit.chamber % 2 == 0) : (hit.chamber % 2 == 1));
+	if (iSt == 0 && hit.ring == 3) trk.FR[iSt] = 0;
+	if (trk.endcap == 0) trk.endcap = hit.endcap;
+      }
+      batch.push_back( trk );
+    } // End loop: for (UInt_t iTrk = 0; iTrk < trks_hits[mode].size(); iTrk++)
+  } // End loop: for (int mode = 15; mode >= 3; mode--)
+
+  if (client) client->Assign( batch, results );
+  else        assigner.Assign( batch, results );
+  for (UInt_t iTrk = 0; iTrk < results.size(); iTrk++) {
+    if (results[iTrk].pt_word < 0) continue;  // No LUT or BDT for the mode on the server
+    hash = (hash ^ uint64_t(results[iTrk].pt_word + 1)) * 0x100000001b3ULL;  // FNV-1a over the pT words
+    nTrk += 1;
+  }
+
+  return best_mode;
+
+} // End function: int ReplayBench::ProcessEvent()
+
+
+void ReplayBench::Run( const int n_pass ) {
+
+  const Long64_t nEvt = NEvents();
+  lat_all.Reset();
+  for (int iMode = 0; iMode < 16; iMode++)     lat_mode.at(iMode).Reset();
+  for (int iMult = 0; iMult < N_MULT; iMult++) lat_mult.at(iMult).Reset();
+  seconds   = 0;
+  n_evt_run = 0;
+  n_trk     = 0;
+
+  // Warm-up pass: working arrays reach their final capacity, LUT pages are mapped in
+  uint64_t hash0 = 0xcbf29ce484222325ULL;
+  Long64_t nTrk0 = 0;
+  for (Long64_t iEvt = 0; iEvt < nEvt; iEvt++)
+    ProcessEvent( iEvt, hash0, nTrk0 );
+  checksum = hash0;
+
+  for (int iPass = 0; iPass < n_pass; iPass++) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    Long64_t nTrk = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point t0 = start;
+    for (Long64_t iEvt = 0; iEvt < nEvt; iEvt++) {
+      const int mode = ProcessEvent( iEvt, hash, nTrk );
+      const std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+      const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>( t1 - t0 ).count();
+      t0 = t1;  // One clock read per event: the end of one event is the start of the next
+      lat_all.Fill( ns );
+      lat_mode[mode].Fill( ns );
+      lat_mult[MultBin( int(evt_first[iEvt + 1] - evt_first[iEvt]) )].Fill( ns );
+    }
+    seconds   += std::chrono::duration<double>( t0 - start ).count();
+    n_evt_run += nEvt;
+    n_trk     += nTrk;
+    if (hash != checksum || nTrk != nTrk0)
+      std::cout << "ERROR: pass " << iPass << " gave a different pT checksum than the warm-up pass" << std::endl;
+  }
+
+} // End function: void ReplayBench::Run()
+
+
+static void PrintLatencyRow( const TString label, const LatencyHist& h ) {
+  std::cout << std::setw(10) << label << std::setw(12) << h.n
+	    << std::setw(10) << h.Mean() << std::setw(10) << h.Percentile(0.5)
+	    << std::setw(10) << h.Percentile(0.99) << std::setw(10) << h.Percentile(0.999)
+	    << std::setw(12) << h.max << std::endl;
+}
+
+
+void ReplayBench::Print() const {
+
+  std::cout << "\n******* Replay of " << NEvents() << " events (" << source << "), "
+	    << (client ? "server" : (assigner.use_BDT ? "BDT" : "LUT")) << " pT *******" << std::endl;
+  std::cout << "  " << n_evt_run << " events, " << n_trk << " tracks in " << seconds << " s: "
+	    << (seconds > 0 ? n_evt_run / seconds : 0) << " events / s, "
+	    << (seconds > 0 ? n_trk / seconds : 0) << " tracks / s" << std::endl;
+  std::cout << std::fixed << std::setprecision(0);
+
+  std::cout << "\nLatency (ns) by mode of the best track" << std::endl;
+  std::cout << std::setw(10) << "mode" << std::setw(12) << "events" << std::setw(10) << "mean" << std::setw(10) << "p50"
+	    << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(12) << "max" << std::endl;
+  PrintLatencyRow( "all", lat_all );
+  for (int mode = 15; mode >= 0; mode--)
+    if (lat_mode.at(mode).n > 0)
+      PrintLatencyRow( Form("%d", mode), lat_mode.at(mode) );
+
+  std::cout << "\nLatency (ns) by hit multiplicity" << std::endl;
+  std::cout << std::setw(10) << "hits" << std::setw(12) << "events" << std::setw(10) << "mean" << std::setw(10) << "p50"
+	    << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(12) << "max" << std::endl;
+  for (int iMult = 0; iMult < N_MULT; iMult++)
+    if (lat_mult.at(iMult).n > 0)
+      PrintLatencyRow( MultLabel(iMult), lat_mult.at(iMult) );
+
+  std::cout << std::defaultfloat << std::setprecision(6);
+
+} // End function: void ReplayBench::Print()
+
+
+void ReplayBench::Summary( const TString label, const TString file_name ) const {
+
+  std::stringstream ss;
+  ss << "REPLAY label=" << label << " source=" << source << " eval=" << (client ? "server" : (assigner.use_BDT ? "BDT" : "LUT"))
+     << " events=" << n_evt_run << " tracks=" << n_trk
+     << " evt_per_s=" << std::setprecision(6) << (seconds > 0 ? n_evt_run / seconds : 0)
+     << " mean_ns=" << lat_all.Mean() << " p50_ns=" << lat_all.Percentile(0.5)
+     << " p99_ns=" << lat_all.Percentile(0.99) << " p999_ns=" << lat_all.Percentile(0.999)
+     << " checksum=" << std::hex << checksum << std::dec;
+  for (int mode = 15; mode >= 0; mode--)
+    if (lat_mode.at(mode).n > 0)
+      ss << " p99_ns_mode" << mode << "=" << lat_mode.at(mode).Percentile(0.99);
+
+  std::cout << ss.str() << std::endl;
+  if (file_name.Length() > 0) {
+    std::ofstream out( file_name.Data(), std::ios::app );
+    if (!out) std::cout << "ERROR: could not append to " << file_name << std::endl;
+    else      out << ss.str() << std::endl;
+  }
+
+} // End function: void ReplayBench::Summary()
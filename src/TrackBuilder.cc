@@ -1,6 +1,47 @@
 
 #include "../interface/TrackBuilder.h"
 
+#include "Rtypes.h"
+
+#include <cassert>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+void GetModeCuts( const int mode, int& minCSC, int& maxRPC ) {
+
+  // 4-station mode
+  if (mode == 15) {
+    minCSC = 3; 
+    maxRPC = 1; // Saves time on training ... ideally should change back to 2? - AWB 02.06.17
+  } 
+  
+  // 3-station modes
+  if (mode == 14 || mode == 13 || mode == 11 || mode == 7) {
+    minCSC = 2;
+    maxRPC = 1;
+  }
+
+  // 2-station modes
+  if (mode == 12 || mode == 10 || mode == 9 || mode == 6 || mode == 5 || mode == 3) {
+    minCSC = 1;
+    maxRPC = 1;
+  }
+
+} // End function: void GetModeCuts()
+
+
+void GetAllModeCuts( std::array<int, 16>& minCSC, std::array<int, 16>& maxRPC ) {
+
+  for (int iMode = 0; iMode < 16; iMode++) {
+    minCSC.at(iMode) = -1;
+    maxRPC.at(iMode) = -1;
+    GetModeCuts( iMode, minCSC.at(iMode), maxRPC.at(iMode) );
+  }
+
+} // End function: void GetAllModeCuts()
+
+
 void BuildTracks( std::vector< std::array<int, 4> >& trks_hits,  // Vector of tracks, with hit indices by station
 		  std::vector< std::array<int, 5> >& trks_modes, // Mode, CSC mode, RPC mode, and sumAbsDPhi/Theta of tracks
 		  const std::array< std::array< std::vector<int>, 4>, 12> id, // All hit index values, by sector and station
@@ -10,8 +51,8 @@ void BuildTracks( std::vector< std::array<int, 4> >& trks_hits,  // Vector of tr
 		  const int mode,            // Mode of track we're building
 		  const int maxRPC,          // Maximum # of stations with RPC hits
 		  const int minCSC,          // Minimum # of stations with CSC hits
-		  const int max_dPh=1024,    // Maximum dPhi between any two hits
-		  const int max_dTh=8        // Maximum dTheta between any two hits
+		  const int max_dPh,         // Maximum dPhi between any two hits
+		  const int max_dTh          // Maximum dTheta between any two hits
 		  ) {
 
   trks_hits.clear();
@@ -52,7 +93,7 @@ void BuildTracks( std::vector< std::array<int, 4> >& trks_hits,  // Vector of tr
     std::vector< std::array<int, 5> > s_trks_modes;
 
     // Loop over station 1 hits
-    for (UInt_t i1 = 0; i1 < max(int(id.at(iSc).at(0).size()), 1); i1++) {
+    for (UInt_t i1 = 0; i1 < std::max(int(id.at(iSc).at(0).size()), 1); i1++) {
       if (mode >= 8 && id.at(iSc).at(0).size() > 0) {
 	phs.at(0) = ph.at(iSc).at(0).at(i1);
 	ths.at(0) = th.at(iSc).at(0).at(i1);
@@ -61,7 +102,7 @@ void BuildTracks( std::vector< std::array<int, 4> >& trks_hits,  // Vector of tr
       }
       
       // Loop over station 2 hits
-      for (UInt_t i2 = 0; i2 < max(int(id.at(iSc).at(1).size()), 1); i2++) {
+      for (UInt_t i2 = 0; i2 < std::max(int(id.at(iSc).at(1).size()), 1); i2++) {
 	if ( (mode % 8) / 4 > 0 && id.at(iSc).at(1).size() > 0) {
 	  phs.at(1) = ph.at(iSc).at(1).at(i2);
 	  ths.at(1) = th.at(iSc).at(1).at(i2);
@@ -70,7 +111,7 @@ void BuildTracks( std::vector< std::array<int, 4> >& trks_hits,  // Vector of tr
 	}
 	
 	// Loop over station 3 hits
-	for (UInt_t i3 = 0; i3 < max(int(id.at(iSc).at(2).size()), 1); i3++) {
+	for (UInt_t i3 = 0; i3 < std::max(int(id.at(iSc).at(2).size()), 1); i3++) {
 	  if ( (mode % 4) / 2 > 0 && id.at(iSc).at(2).size() > 0) {
 	    phs.at(2) = ph.at(iSc).at(2).at(i3);
 	    ths.at(2) = th.at(iSc).at(2).at(i3);
@@ -79,7 +120,7 @@ void BuildTracks( std::vector< std::array<int, 4> >& trks_hits,  // Vector of tr
 	  }
 	  
 	  // Loop over station 4 hits
-	  for (UInt_t i4 = 0; i4 < max(int(id.at(iSc).at(3).size()), 1); i4++) {
+	  for (UInt_t i4 = 0; i4 < std::max(int(id.at(iSc).at(3).size()), 1); i4++) {
 	    if ( (mode % 2) > 0 && id.at(iSc).at(3).size() > 0) {
 	      phs.at(3) = ph.at(iSc).at(3).at(i4);
 	      ths.at(3) = th.at(iSc).at(3).at(i4);
@@ -132,6 +173,112 @@ void BuildTracks( std::vector< std::array<int, 4> >& trks_hits,  // Vector of tr
 
 
 
+void BuildTracksAllModes( std::array< std::vector< std::array<int, 4> >, 16>& trks_hits,  // Tracks of each mode, with hit indices by station
+			  std::array< std::vector< std::array<int, 5> >, 16>& trks_modes, // Mode, CSC mode, RPC mode, and sumAbsDPhi/Theta of tracks
+			  const std::array< std::array< std::vector<int>, 4>, 12> id, // All hit index values, by sector and station
+			  const std::array< std::array< std::vector<int>, 4>, 12> ph, // All full-precision integer phi values
+			  const std::array< std::array< std::vector<int>, 4>, 12> th, // All full-precision integer theta values
+			  const std::array< std::array< std::vector<int>, 4>, 12> dt, // All detector values (0 for none, 1 for CSC, 2 for RPC)
+			  const std::array<int, 16> maxRPC,  // Maximum # of stations with RPC hits, by mode
+			  const std::array<int, 16> minCSC,  // Minimum # of stations with CSC hits, by mode (-1 to skip the mode)
+			  const int max_dPh,         // Maximum dPhi between any two hits
+			  const int max_dTh          // Maximum dTheta between any two hits
+			  ) {
+
+  for (int iMode = 0; iMode < 16; iMode++) {
+    trks_hits.at(iMode).clear();
+    trks_modes.at(iMode).clear();
+  }
+
+  std::array<int, 4> phs, ths, dts; // Phi, theta, and detector by station
+  std::array<int, 4> idx;           // Hit index in each station, -1 for none
+
+  // Loop over the sectors
+  for (UInt_t iSc = 0; iSc < 12; iSc++) {
+
+    // Check for consistency
+    UInt_t nHitsTot = 0;
+    for (UInt_t iSt = 0; iSt < 4; iSt++) {
+      UInt_t nHits = id.at(iSc).at(iSt).size();
+      assert( ph.at(iSc).at(iSt).size() == nHits &&
+	      th.at(iSc).at(iSt).size() == nHits &&
+	      dt.at(iSc).at(iSt).size() == nHits );
+      nHitsTot += nHits;
+    }
+    if (nHitsTot == 0)
+      continue;
+
+    // Create new vectors of tracks of each mode for this sector
+    std::array< std::vector< std::array<int, 4> >, 16> s_trks_hits;
+    std::array< std::vector< std::array<int, 5> >, 16> s_trks_modes;
+
+    // Each station takes one of its hits, or none (-1); each combination is visited once for all modes
+    for (idx.at(0) = -1; idx.at(0) < int(id.at(iSc).at(0).size()); idx.at(0)++) {
+      for (idx.at(1) = -1; idx.at(1) < int(id.at(iSc).at(1).size()); idx.at(1)++) {
+	for (idx.at(2) = -1; idx.at(2) < int(id.at(iSc).at(2).size()); idx.at(2)++) {
+	  for (idx.at(3) = -1; idx.at(3) < int(id.at(iSc).at(3).size()); idx.at(3)++) {
+
+	    // Mode of the stations chosen in this combination
+	    int mode = 0;
+	    for (int iSt = 0; iSt < 4; iSt++) {
+	      if (idx.at(iSt) < 0) {
+		phs.at(iSt) = -99;
+		ths.at(iSt) = -99;
+		dts.at(iSt) =   0;
+	      } else {
+		phs.at(iSt) = ph.at(iSc).at(iSt).at(idx.at(iSt));
+		ths.at(iSt) = th.at(iSc).at(iSt).at(idx.at(iSt));
+		dts.at(iSt) = dt.at(iSc).at(iSt).at(idx.at(iSt));
+		mode += pow(2, 3 - iSt);
+	      }
+	    }
+	    if (mode == 0 || mode == 1 || mode == 2 || mode == 4 || mode == 8) continue;  // Single-station
+	    if (minCSC.at(mode) < 0) continue;  // Mode not requested
+
+	    // Classify without CSC / RPC cuts, then apply the cuts of this mode
+	    int _mode, _mode_CSC, _mode_RPC;
+	    int _sumAbsDPh, _sumAbsDTh;
+	    BuiltTrackMode( _mode, _mode_CSC, _mode_RPC, _sumAbsDPh, _sumAbsDTh,
+			    phs, ths, dts, 4, 0, max_dPh, max_dTh );
+	    if (_mode != mode) continue;  // A station failed the dPhi / dTheta cuts: built as a lower mode elsewhere
+
+	    int nCSC = (_mode_CSC / 8) + (_mode_CSC % 8) / 4 + (_mode_CSC % 4) / 2 + (_mode_CSC % 2);
+	    int nRPC = (_mode_RPC / 8) + (_mode_RPC % 8) / 4 + (_mode_RPC % 4) / 2 + (_mode_RPC % 2);
+	    if (nCSC < minCSC.at(mode) || nRPC > maxRPC.at(mode)) continue;
+
+	    std::array<int, 4> trk_hits;
+	    std::array<int, 5> trk_modes;
+	    for (int iSt = 0; iSt < 4; iSt++)
+	      trk_hits.at(iSt) = (idx.at(iSt) >= 0 ? id.at(iSc).at(iSt).at(idx.at(iSt)) : -99);
+
+	    trk_modes.at(0) = (_mode);
+	    trk_modes.at(1) = (_mode_CSC);
+	    trk_modes.at(2) = (_mode_RPC);
+	    trk_modes.at(3) = (_sumAbsDPh);
+	    trk_modes.at(4) = (_sumAbsDTh);
+
+	    s_trks_hits.at(mode).push_back(trk_hits);
+	    s_trks_modes.at(mode).push_back(trk_modes);
+
+	  } // End loop: for (idx.at(3) = -1; idx.at(3) < nHits; idx.at(3)++)
+	} // End loop: for (idx.at(2) = -1; idx.at(2) < nHits; idx.at(2)++)
+      } // End loop: for (idx.at(1) = -1; idx.at(1) < nHits; idx.at(1)++)
+    } // End loop: for (idx.at(0) = -1; idx.at(0) < nHits; idx.at(0)++)
+
+    // Select tracks with lowest sumAbsDPh, then sumAbsDTh, for a given CSC mode and RPC mode, separately in each mode
+    for (int iMode = 0; iMode < 16; iMode++) {
+      if (s_trks_hits.at(iMode).size() == 0) continue;
+      SelectTracks( s_trks_hits.at(iMode), s_trks_modes.at(iMode) );
+      trks_hits.at(iMode).insert( trks_hits.at(iMode).end(), s_trks_hits.at(iMode).begin(), s_trks_hits.at(iMode).end() );
+      trks_modes.at(iMode).insert( trks_modes.at(iMode).end(), s_trks_modes.at(iMode).begin(), s_trks_modes.at(iMode).end() );
+    }
+
+  } // End loop: for (UInt_t iSc = 0; iSc < 12; iSc++)
+
+} // End function: void BuildTracksAllModes()
+
+
+
 void BuiltTrackMode( int& mode, int& mode_CSC, int& mode_RPC, int& sumAbsDPh, int& sumAbsDTh,
 		     const std::array<int, 4> phs, // Full-precision integer phi by station
 		     const std::array<int, 4> ths, // Full-precision integer theta by station
@@ -0,0 +1,215 @@
+
+#include "../interface/TreeWriter.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TObjArray.h"
+#include "TObject.h"
+#include "TDirectory.h"
+#include "TSystem.h"
+#include "TROOT.h"
+
+#include <iostream>
+#include <chrono>
+
+// Compression of a branch and its sub-branches: cloned branches keep the settings of the source tree
+static void TWSetCompression( TObjArray* branches, const int settings ) {
+  for (int i = 0; i < branches->GetEntriesFast(); i++) {
+    TBranch* br = (TBranch*) branches->At(i);
+    br->SetCompressionSettings( settings );
+    TWSetCompression( br->GetListOfBranches(), settings );
+  }
+}
+
+// Directory dir_name of file, created if needed
+static TDirectory* TWDirectory( TFile* file, const TString dir_name ) {
+  if (dir_name == "") return file;
+  TDirectory* dir = file->GetDirectory( dir_name );
+  return (dir ? dir : file->mkdir( dir_name ));
+}
+
+static double TWSeconds( const std::chrono::steady_clock::time_point start ) {
+  return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+}
+
+
+AsyncTreeWriter::AsyncTreeWriter( const TString _tmp_file_name, const int _algorithm, const int _level,
+				  const int _basket_size, const std::vector<TString>& _drop_branches, const bool _async ) {
+
+  tmp_file_name = _tmp_file_name;
+  algorithm     = _algorithm;
+  level         = _level;
+  basket_size   = _basket_size;
+  drop_branches = _drop_branches;
+  async         = _async;
+  n_trees   = 0;
+  bytes_in  = 0;
+  bytes_out = 0;
+  write_sec = 0;
+  wait_sec  = 0;
+  copy_sec  = 0;
+  file = 0;
+  ok   = true;
+  stop = false;
+
+  if (async) {
+    ROOT::EnableThreadSafety();  // The writer thread fills its own file alongside the training in the main thread
+    thread = std::thread( &AsyncTreeWriter::Run, this );
+  }
+
+} // End constructor AsyncTreeWriter()
+
+
+AsyncTreeWriter::~AsyncTreeWriter() {
+
+  // Without Finish(): drop the queued trees and the temporary file
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stop = true;
+    for (UInt_t i = 0; i < queue.size(); i++)
+      delete queue.at(i).first;
+    queue.clear();
+  }
+  cv.notify_all();
+  if (thread.joinable())
+    thread.join();
+  if (file) {
+    file->Close();
+    delete file;
+    gSystem->Unlink( tmp_file_name );
+  }
+
+} // End destructor AsyncTreeWriter()
+
+
+void AsyncTreeWriter::Write( TTree* tree, const TString dir_name ) {
+
+  if (tree == 0) return;
+  tree->SetDirectory(0);  // Never flushed into the output file, nor deleted with it
+
+  if (!async) {
+    WriteTree( tree, dir_name );
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    queue.push_back( std::make_pair(tree, dir_name) );
+  }
+  cv.notify_all();
+
+} // End function: void AsyncTreeWriter::Write()
+
+
+void AsyncTreeWriter::Run() {
+
+  while (true) {
+    std::pair<TTree*, TString> job;
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      cv.wait( lock, [&]{ return stop || !queue.empty(); } );
+      if (queue.empty()) return;  // Stopped, and all trees written
+      job = queue.front();
+      queue.pop_front();
+    }
+    WriteTree( job.first, job.second );
+  }
+
+} // End function: void AsyncTreeWriter::Run()
+
+
+void AsyncTreeWriter::WriteTree( TTree* tree, const TString dir_name ) {
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  if (file == 0) {
+    file = new TFile( tmp_file_name, "RECREATE" );
+    if (file->IsZombie()) {
+      std::cout << "ERROR: could not create " << tmp_file_name << ", " << tree->GetName() << " is not written" << std::endl;
+      delete file;
+      file = 0;
+      ok = false;
+      delete tree;
+      return;
+    }
+    file->SetCompressionAlgorithm( algorithm );
+    file->SetCompressionLevel( level );
+  }
+
+  // Dropped branches are not cloned
+  for (UInt_t i = 0; i < drop_branches.size(); i++)
+    tree->SetBranchStatus( drop_branches.at(i), 0 );
+
+  TWDirectory( file, dir_name )->cd();
+  TTree* copy = tree->CloneTree(0);
+  TWSetCompression( copy->GetListOfBranches(), file->GetCompressionSettings() );
+  copy->SetBasketSize( "*", basket_size );
+  copy->CopyEntries( tree );
+  copy->Write( "", TObject::kOverwrite );
+
+  n_trees   += 1;
+  bytes_in  += copy->GetTotBytes();
+  bytes_out += copy->GetZipBytes();
+  written.push_back( std::make_pair(dir_name, TString(copy->GetName())) );
+  delete tree;
+  delete copy;
+  write_sec += TWSeconds( start );
+
+} // End function: void AsyncTreeWriter::WriteTree()
+
+
+bool AsyncTreeWriter::Finish( TFile* out_file ) {
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stop = true;
+  }
+  cv.notify_all();
+  if (thread.joinable())
+    thread.join();
+  wait_sec = TWSeconds( start );
+
+  if (file == 0) return ok;
+  file->Close();
+  delete file;
+  file = 0;
+
+  // Fast clone: the compressed baskets are copied as they are
+  start = std::chrono::steady_clock::now();
+  TFile* in_file = TFile::Open( tmp_file_name );
+  for (UInt_t i = 0; in_file && i < written.size(); i++) {
+    const TString path = (written.at(i).first == "" ? written.at(i).second : written.at(i).first + "/" + written.at(i).second);
+    TTree* tree = (TTree*) in_file->Get( path );
+    if (tree == 0) {
+      std::cout << "ERROR: " << path << " is missing from " << tmp_file_name << std::endl;
+      ok = false;
+      continue;
+    }
+    TWDirectory( out_file, written.at(i).first )->cd();
+    TTree* copy = tree->CloneTree( -1, "fast" );
+    copy->Write( "", TObject::kOverwrite );
+    delete copy;
+  }
+  if (in_file) {
+    in_file->Close();
+    delete in_file;
+  } else ok = false;
+  gSystem->Unlink( tmp_file_name );
+  copy_sec = TWSeconds( start );
+
+  if (!ok) std::cout << "ERROR: not all output trees could be written to " << out_file->GetName() << std::endl;
+  return ok;
+
+} // End function: bool AsyncTreeWriter::Finish()
+
+
+void AsyncTreeWriter::Print() const {
+
+  std::cout << "\nOutput trees: " << n_trees << " trees, " << bytes_in / 1.e6 << " MB -> " << bytes_out / 1.e6
+	    << " MB (algorithm " << algorithm << ", level " << level << ", baskets of " << basket_size << " bytes, "
+	    << drop_branches.size() << " branch patterns dropped)" << std::endl;
+  std::cout << "  * " << write_sec << " s compressing" << (async ? " on the writer thread" : "")
+	    << ", " << wait_sec << " s waiting for it, " << copy_sec << " s copying into the output file" << std::endl;
+
+} // End function: void AsyncTreeWriter::Print()
@@ -0,0 +1,152 @@
+
+#include "../interface/VarGraph.h"
+
+#include <iostream>
+
+// Variable name, id and the node it is read from
+struct VGVarDef {
+  const char*    name;
+  VarGraph::Var  var;
+  VarGraph::Node node;
+};
+
+static const VGVarDef VGVars[] = {
+  { "theta",           VarGraph::kTheta,         VarGraph::kCalcTheta },
+  { "St1_ring2",       VarGraph::kSt1Ring2,      VarGraph::kHitRing1 },
+  { "dPhi_12",         VarGraph::kDPhi12,        VarGraph::kCalcDeltaPhis },
+  { "dPhi_13",         VarGraph::kDPhi13,        VarGraph::kCalcDeltaPhis },
+  { "dPhi_14",         VarGraph::kDPhi14,        VarGraph::kCalcDeltaPhis },
+  { "dPhi_23",         VarGraph::kDPhi23,        VarGraph::kCalcDeltaPhis },
+  { "dPhi_24",         VarGraph::kDPhi24,        VarGraph::kCalcDeltaPhis },
+  { "dPhi_34",         VarGraph::kDPhi34,        VarGraph::kCalcDeltaPhis },
+  { "FR_1",            VarGraph::kFR1,           VarGraph::kCalcFRs },
+  { "FR_2",            VarGraph::kFR2,           VarGraph::kCalcFRs },
+  { "FR_3",            VarGraph::kFR3,           VarGraph::kCalcFRs },
+  { "FR_4",            VarGraph::kFR4,           VarGraph::kCalcFRs },
+  { "bend_1",          VarGraph::kBend1,         VarGraph::kCalcBends },
+  { "bend_2",          VarGraph::kBend2,         VarGraph::kCalcBends },
+  { "bend_3",          VarGraph::kBend3,         VarGraph::kCalcBends },
+  { "bend_4",          VarGraph::kBend4,         VarGraph::kCalcBends },
+  { "dPhiSum4",        VarGraph::kDPhiSum4,      VarGraph::kCalcDeltaPhiSums },
+  { "dPhiSum4A",       VarGraph::kDPhiSum4A,     VarGraph::kCalcDeltaPhiSums },
+  { "dPhiSum3",        VarGraph::kDPhiSum3,      VarGraph::kCalcDeltaPhiSums },
+  { "dPhiSum3A",       VarGraph::kDPhiSum3A,     VarGraph::kCalcDeltaPhiSums },
+  { "outStPhi",        VarGraph::kOutStPhi,      VarGraph::kCalcDeltaPhiSums },
+  { "dTh_12",          VarGraph::kDTh12,         VarGraph::kCalcDeltaThetas },
+  { "dTh_13",          VarGraph::kDTh13,         VarGraph::kCalcDeltaThetas },
+  { "dTh_14",          VarGraph::kDTh14,         VarGraph::kCalcDeltaThetas },
+  { "dTh_23",          VarGraph::kDTh23,         VarGraph::kCalcDeltaThetas },
+  { "dTh_24",          VarGraph::kDTh24,         VarGraph::kCalcDeltaThetas },
+  { "dTh_34",          VarGraph::kDTh34,         VarGraph::kCalcDeltaThetas },
+  { "RPC_1",           VarGraph::kRPC1,          VarGraph::kCalcRPCs },
+  { "RPC_2",           VarGraph::kRPC2,          VarGraph::kCalcRPCs },
+  { "RPC_3",           VarGraph::kRPC3,          VarGraph::kCalcRPCs },
+  { "RPC_4",           VarGraph::kRPC4,          VarGraph::kCalcRPCs },
+  { "GEN_pt_trg",      VarGraph::kGenPtTrg,      VarGraph::kNoNode },
+  { "inv_GEN_pt_trg",  VarGraph::kInvGenPtTrg,   VarGraph::kNoNode },
+  { "log2_GEN_pt_trg", VarGraph::kLog2GenPtTrg,  VarGraph::kNoNode },
+  { "sqrt_GEN_pt_trg", VarGraph::kSqrtGenPtTrg,  VarGraph::kNoNode },
+  { "GEN_charge_trg",  VarGraph::kGenChargeTrg,  VarGraph::kCalcDeltaPhis },  // Charge x dPhSign
+  { "GEN_pt",          VarGraph::kGenPt,         VarGraph::kNoNode },
+  { "EMTF_pt",         VarGraph::kEmtfPt,        VarGraph::kNoNode },
+  { "inv_GEN_pt",      VarGraph::kInvGenPt,      VarGraph::kNoNode },
+  { "inv_EMTF_pt",     VarGraph::kInvEmtfPt,     VarGraph::kNoNode },
+  { "log2_GEN_pt",     VarGraph::kLog2GenPt,     VarGraph::kNoNode },
+  { "log2_EMTF_pt",    VarGraph::kLog2EmtfPt,    VarGraph::kNoNode },
+  { "GEN_eta",         VarGraph::kGenEta,        VarGraph::kNoNode },
+  { "EMTF_eta",        VarGraph::kEmtfEta,       VarGraph::kNoNode },
+  { "TRK_eta",         VarGraph::kTrkEta,        VarGraph::kHitEtaPhi },
+  { "GEN_phi",         VarGraph::kGenPhi,        VarGraph::kNoNode },
+  { "EMTF_phi",        VarGraph::kEmtfPhi,       VarGraph::kNoNode },
+  { "TRK_phi",         VarGraph::kTrkPhi,        VarGraph::kHitEtaPhi },
+  { "GEN_charge",      VarGraph::kGenCharge,     VarGraph::kNoNode },
+  { "EMTF_charge",     VarGraph::kEmtfCharge,    VarGraph::kNoNode },
+  { "EMTF_mode",       VarGraph::kEmtfMode,      VarGraph::kNoNode },
+  { "EMTF_mode_CSC",   VarGraph::kEmtfModeCSC,   VarGraph::kNoNode },
+  { "EMTF_mode_RPC",   VarGraph::kEmtfModeRPC,   VarGraph::kNoNode },
+  { "TRK_mode",        VarGraph::kTrkMode,       VarGraph::kNoNode },
+  { "TRK_mode_CSC",    VarGraph::kTrkModeCSC,    VarGraph::kNoNode },
+  { "TRK_mode_RPC",    VarGraph::kTrkModeRPC,    VarGraph::kNoNode },
+  { "SHRD_mode",       VarGraph::kShrdMode,      VarGraph::kSharedMode },
+  { "SHRD_mode_CSC",   VarGraph::kShrdModeCSC,   VarGraph::kSharedMode },
+  { "SHRD_mode_RPC",   VarGraph::kShrdModeRPC,   VarGraph::kSharedMode },
+  { "dPhi_sign",       VarGraph::kDPhiSign,      VarGraph::kCalcDeltaPhis },
+  { "nTRK",            VarGraph::kNTrk,          VarGraph::kNoNode },
+  { "evt_weight",      VarGraph::kEvtWeight,     VarGraph::kNoNode }
+};
+static const int VGNVars = sizeof(VGVars) / sizeof(VGVars[0]);
+
+// Inputs of each node: node needs input
+static const VarGraph::Node VGInputs[][2] = {
+  { VarGraph::kCalcTheta,        VarGraph::kHitRing1 },
+  { VarGraph::kCalcDeltaPhiSums, VarGraph::kCalcDeltaPhis },
+  { VarGraph::kCalcFRs,          VarGraph::kHitRing1 },
+  { VarGraph::kCalcBends,        VarGraph::kCalcDeltaPhis },  // dPhSign
+  { VarGraph::kCalcRPCs,         VarGraph::kCalcTheta },
+  { VarGraph::kCalcRPCs,         VarGraph::kHitRing1 }
+};
+static const int VGNInputs = sizeof(VGInputs) / sizeof(VGInputs[0]);
+
+static const char* VGNodeNames[VarGraph::kNoNode] = {
+  "ring1", "CalcTrackTheta", "CalcDeltaPhis", "dPhi sums", "CalcDeltaThetas",
+  "FRs", "CalcBends", "CalcRPCs", "track eta / phi", "shared mode"
+};
+
+
+VarGraph::Var VarGraph::Id( const TString name ) {
+  for (int i = 0; i < VGNVars; i++)
+    if (name == VGVars[i].name) return VGVars[i].var;
+  return kUnknown;
+}
+
+VarGraph::Node VarGraph::NodeOf( const Var var ) {
+  for (int i = 0; i < VGNVars; i++)
+    if (var == VGVars[i].var) return VGVars[i].node;
+  return kNoNode;
+}
+
+
+std::vector<int> VarGraph::Require( const std::vector<TString>& names ) {
+
+  std::vector<int> ids;
+  for (UInt_t i = 0; i < names.size(); i++) {
+    const Var var = Id( names.at(i) );
+    ids.push_back( var );
+    if (var == kUnknown) continue;
+    const Node node = NodeOf( var );
+    if (node != kNoNode) required.at(node) = true;
+  }
+  return ids;
+
+} // End function: std::vector<int> VarGraph::Require()
+
+
+void VarGraph::Resolve() {
+
+  // Add the inputs of needed nodes until nothing changes (the graph is small and acyclic)
+  needed = required;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int i = 0; i < VGNInputs; i++) {
+      if ( needed.at(VGInputs[i][0]) && !needed.at(VGInputs[i][1]) ) {
+	needed.at(VGInputs[i][1]) = true;
+	changed = true;
+      }
+    }
+  }
+
+} // End function: void VarGraph::Resolve()
+
+
+void VarGraph::Print() const {
+
+  TString computed = "", skipped = "";
+  for (int i = 0; i < kNoNode; i++) {
+    TString& list = (needed.at(i) ? computed : skipped);
+    list += (list == "" ? "" : ", ") + TString(VGNodeNames[i]) + (needed.at(i) && !required.at(i) ? " (input)" : "");
+  }
+  std::cout << "\nPer-track variables: computing " << (computed == "" ? "none" : computed.Data())
+	    << "; skipping " << (skipped == "" ? "none" : skipped.Data()) << std::endl;
+
+} // End function: void VarGraph::Print()
@@ -0,0 +1,334 @@
+
+#include "../interface/VarSearch.h"
+#include "../interface/KFoldTrainer.h"  // Fold()
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <cassert>
+
+const int    VarSearch::N_BINS;
+const int    VarSearch::N_TREES;
+const int    VarSearch::DEPTH;
+const double VarSearch::SHRINKAGE = 0.3;
+const int    VarSearch::PRUNE_AFTER;
+const double VarSearch::PRUNE_TOL = 0.01;
+const double VarSearch::MIN_GAIN  = 0.001;
+
+
+void VarSearch::AddEvent( const ULong64_t event_id, const std::vector<Double_t>& var_vals, const Double_t weight ) {
+
+  assert( var_vals.size() >= var_names.size() && bins.empty() );
+  values.insert( values.end(), var_vals.begin(), var_vals.begin() + var_names.size() );
+  weights.push_back( weight );
+  valid.push_back( KFoldTrainer::Fold( event_id, 4 ) == 0 );
+
+} // End function: void VarSearch::AddEvent()
+
+
+void VarSearch::BinInputs() {
+
+  const Long64_t nEvt  = NEvents();
+  const int      nVars = var_names.size();
+  const int      nIn   = bits.size();
+
+  i_train.clear();
+  i_valid.clear();
+  target.resize( nEvt );
+  for (Long64_t iEvt = 0; iEvt < nEvt; iEvt++) {
+    target.at(iEvt) = values.at( iEvt * nVars + nIn );
+    if (valid.at(iEvt)) i_valid.push_back( iEvt );
+    else                i_train.push_back( iEvt );
+  }
+
+  // Bin edges at the quantiles of the training sample, or between the values of discrete variables
+  bins.resize( Long64_t(nIn) * nEvt );
+  std::vector<Float_t> sorted( i_train.size() );
+  for (int iVar = 0; iVar < nIn; iVar++) {
+    for (UInt_t i = 0; i < i_train.size(); i++)
+      sorted.at(i) = values.at( i_train.at(i) * nVars + iVar );
+    std::sort( sorted.begin(), sorted.end() );
+    std::vector<Float_t> distinct( sorted.begin(), std::unique( sorted.begin(), sorted.end() ) );
+
+    std::vector<Float_t> edges;
+    if ( int(distinct.size()) <= N_BINS ) {
+      for (UInt_t i = 1; i < distinct.size(); i++)
+	edges.push_back( 0.5 * (distinct.at(i - 1) + distinct.at(i)) );
+    } else {
+      for (UInt_t i = 0; i < i_train.size(); i++)
+	sorted.at(i) = values.at( i_train.at(i) * nVars + iVar );
+      std::sort( sorted.begin(), sorted.end() );
+      for (int iBin = 1; iBin < N_BINS; iBin++) {
+	const Float_t edge = sorted.at( Long64_t(iBin) * sorted.size() / N_BINS );
+	if (edges.empty() || edge > edges.back()) edges.push_back( edge );
+      }
+    }
+
+    for (Long64_t iEvt = 0; iEvt < nEvt; iEvt++) {
+      const Float_t val = values.at( iEvt * nVars + iVar );
+      bins.at( iVar * nEvt + iEvt ) = std::upper_bound( edges.begin(), edges.end(), val ) - edges.begin();
+    }
+  }
+
+} // End function: void VarSearch::BinInputs()
+
+
+VarSearch::Result VarSearch::Evaluate( const UInt_t mask, const double prune_loss ) const {
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  const Long64_t nEvt   = NEvents();
+  const Long64_t nTr    = i_train.size();
+  const Long64_t nVa    = i_valid.size();
+  const int      nNodes = (1 << DEPTH);
+
+  std::vector<int> cols;  // Pool variables in the mask
+  for (UInt_t iVar = 0; iVar < bits.size(); iVar++)
+    if ( 0x1 & (mask >> bits.at(iVar)) ) cols.push_back( iVar );
+  const int nCols = cols.size();
+
+  Result res;
+  res.mask       = mask;
+  res.n_vars     = nCols;
+  res.n_trees    = 0;
+  res.loss_prune = -1;
+  res.pruned     = false;
+
+  // Start from the weighted mean target
+  double sumW = 0, sumWY = 0, sumWVa = 0;
+  for (Long64_t i = 0; i < nTr; i++) {
+    sumW  += weights.at( i_train.at(i) );
+    sumWY += weights.at( i_train.at(i) ) * target.at( i_train.at(i) );
+  }
+  for (Long64_t i = 0; i < nVa; i++)
+    sumWVa += weights.at( i_valid.at(i) );
+  std::vector<double> pred_tr( nTr, sumW > 0 ? sumWY / sumW : 0 );
+  std::vector<double> pred_va( nVa, sumW > 0 ? sumWY / sumW : 0 );
+
+  std::vector<double> resid( nTr );
+  std::vector<int>    node( nTr );
+  std::vector<double> hist_w ( Long64_t(nNodes / 2) * std::max(nCols, 1) * N_BINS );
+  std::vector<double> hist_wr( hist_w.size() );
+  std::vector<int>    split_col( nNodes ), split_bin( nNodes );  // Heap-ordered; col -1 sends everything left
+  std::vector<double> leaf_w( nNodes ), leaf_wr( nNodes );
+
+  res.loss = 0;
+  for (Long64_t i = 0; i < nVa; i++)
+    res.loss += weights.at( i_valid.at(i) ) * pow( target.at( i_valid.at(i) ) - pred_va.at(i), 2 );
+  res.loss = (sumWVa > 0 ? res.loss / sumWVa : 0);
+
+  for (int iTree = 0; iTree < N_TREES && nCols > 0; iTree++) {
+
+    for (Long64_t i = 0; i < nTr; i++) {
+      resid.at(i) = target.at( i_train.at(i) ) - pred_tr.at(i);
+      node.at(i)  = 0;
+    }
+
+    // Grow one level at a time: gradient histograms of every node and variable, then the best cut of each node
+    for (int iLev = 0; iLev < DEPTH; iLev++) {
+      const int nLev = (1 << iLev);
+      std::fill( hist_w .begin(), hist_w .begin() + Long64_t(nLev) * nCols * N_BINS, 0. );
+      std::fill( hist_wr.begin(), hist_wr.begin() + Long64_t(nLev) * nCols * N_BINS, 0. );
+      for (int iCol = 0; iCol < nCols; iCol++) {
+	const UChar_t* col_bins = &bins[ Long64_t(cols.at(iCol)) * nEvt ];
+	for (Long64_t i = 0; i < nTr; i++) {
+	  const Long64_t h = (Long64_t(node[i]) * nCols + iCol) * N_BINS + col_bins[ i_train[i] ];
+	  const double   w = weights[ i_train[i] ];
+	  hist_w [h] += w;
+	  hist_wr[h] += w * resid[i];
+	}
+      }
+
+      for (int iNode = 0; iNode < nLev; iNode++) {
+	double best_gain = 0;
+	split_col.at(nLev + iNode) = -1;
+	split_bin.at(nLev + iNode) = N_BINS;
+	for (int iCol = 0; iCol < nCols; iCol++) {
+	  const double* hw  = &hist_w [ (Long64_t(iNode) * nCols + iCol) * N_BINS ];
+	  const double* hwr = &hist_wr[ (Long64_t(iNode) * nCols + iCol) * N_BINS ];
+	  double W = 0, G = 0;
+	  for (int iBin = 0; iBin < N_BINS; iBin++) { W += hw[iBin]; G += hwr[iBin]; }
+	  if (W <= 0) continue;
+	  double WL = 0, GL = 0;
+	  for (int iBin = 0; iBin < N_BINS - 1; iBin++) {
+	    WL += hw[iBin];
+	    GL += hwr[iBin];
+	    const double WR = W - WL;
+	    if (WL <= 1e-9 * W || WR <= 1e-9 * W) continue;
+	    const double gain = GL * GL / WL + (G - GL) * (G - GL) / WR - G * G / W;
+	    if (gain > best_gain) {
+	      best_gain = gain;
+	      split_col.at(nLev + iNode) = cols.at(iCol);
+	      split_bin.at(nLev + iNode) = iBin;
+	    }
+	  }
+	}
+      } // End loop: for (int iNode = 0; iNode < nLev; iNode++)
+
+      for (Long64_t i = 0; i < nTr; i++) {
+	const int iHeap = nLev + node[i];
+	const bool right = ( split_col[iHeap] >= 0 &&
+			     bins[ Long64_t(split_col[iHeap]) * nEvt + i_train[i] ] > split_bin[iHeap] );
+	node[i] = 2 * node[i] + right;
+      }
+    } // End loop: for (int iLev = 0; iLev < DEPTH; iLev++)
+
+    // Leaf values, then update the training and validation predictions
+    std::fill( leaf_w .begin(), leaf_w .end(), 0. );
+    std::fill( leaf_wr.begin(), leaf_wr.end(), 0. );
+    for (Long64_t i = 0; i < nTr; i++) {
+      leaf_w [ node[i] ] += weights[ i_train[i] ];
+      leaf_wr[ node[i] ] += weights[ i_train[i] ] * resid[i];
+    }
+    for (int iLeaf = 0; iLeaf < nNodes; iLeaf++)
+      leaf_wr.at(iLeaf) = (leaf_w.at(iLeaf) > 0 ? SHRINKAGE * leaf_wr.at(iLeaf) / leaf_w.at(iLeaf) : 0);
+    for (Long64_t i = 0; i < nTr; i++)
+      pred_tr[i] += leaf_wr[ node[i] ];
+
+    double loss = 0;
+    for (Long64_t i = 0; i < nVa; i++) {
+      int iHeap = 1;
+      for (int iLev = 0; iLev < DEPTH; iLev++)
+	iHeap = 2 * iHeap + ( split_col[iHeap] >= 0 &&
+			      bins[ Long64_t(split_col[iHeap]) * nEvt + i_valid[i] ] > split_bin[iHeap] );
+      pred_va[i] += leaf_wr[ iHeap - nNodes ];
+      loss += weights[ i_valid[i] ] * pow( target[ i_valid[i] ] - pred_va[i], 2 );
+    }
+    res.loss     = (sumWVa > 0 ? loss / sumWVa : 0);
+    res.n_trees += 1;
+
+    if (res.n_trees == PRUNE_AFTER) {
+      res.loss_prune = res.loss;
+      if (prune_loss > 0 && res.loss > prune_loss) {
+	res.pruned = true;
+	break;
+      }
+    }
+  } // End loop: for (int iTree = 0; iTree < N_TREES && nCols > 0; iTree++)
+
+  if (res.loss_prune < 0) res.loss_prune = res.loss;
+  res.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+  return res;
+
+} // End function: VarSearch::Result VarSearch::Evaluate()
+
+
+// Unpruned masks by loss, then pruned masks by loss at the pruning point
+static bool VarSearchRank( const VarSearch::Result& a, const VarSearch::Result& b ) {
+  if (a.pruned != b.pruned) return b.pruned;
+  if (a.pruned) return a.loss_prune < b.loss_prune;
+  if (a.loss != b.loss) return a.loss < b.loss;
+  return a.mask < b.mask;
+}
+
+
+std::vector<VarSearch::Result> VarSearch::Search( const UInt_t start_mask, const int beam_width, const int max_steps,
+						  const bool forward, const bool backward ) {
+
+  assert( beam_width >= 1 && n_threads >= 1 );
+  if (bins.empty()) BinInputs();
+  std::cout << "\n******* Searching the input variables of " << name << " with " << i_train.size() << " training and "
+	    << i_valid.size() << " validation tracks, beam width " << beam_width << " *******" << std::endl;
+
+  std::map<UInt_t, Result> done;  // Every mask trained, so none is trained twice
+  std::vector<Result> beam( 1, Evaluate( start_mask ) );
+  done[start_mask] = beam.front();
+
+  for (int iStep = 0; iStep < max_steps; iStep++) {
+
+    // Neighbours of the beam: one variable added or removed
+    std::set<UInt_t> cand_set;
+    for (UInt_t iB = 0; iB < beam.size(); iB++) {
+      for (UInt_t iVar = 0; iVar < bits.size(); iVar++) {
+	const UInt_t bit  = (0x1u << bits.at(iVar));
+	const UInt_t cand = beam.at(iB).mask ^ bit;
+	if ( (beam.at(iB).mask & bit) ? (!backward || beam.at(iB).n_vars <= 1) : !forward ) continue;
+	if ( done.find(cand) == done.end() ) cand_set.insert( cand );
+      }
+    }
+    if (cand_set.empty()) break;
+    const std::vector<UInt_t> cands( cand_set.begin(), cand_set.end() );
+
+    // Candidates worse than the whole (full) beam after PRUNE_AFTER trees are not finished
+    double prune_loss = -1;
+    if ( int(beam.size()) == beam_width )
+      for (UInt_t iB = 0; iB < beam.size(); iB++)
+	prune_loss = std::max( prune_loss, beam.at(iB).loss_prune * (1 + PRUNE_TOL) );
+
+    std::vector<Result> results( cands.size() );
+    std::atomic<int> next(0);
+    std::vector<std::thread> threads;
+    const int nTh = std::min( n_threads, int(cands.size()) );
+    for (int iTh = 0; iTh < nTh; iTh++) {
+      threads.push_back( std::thread( [&]() {
+	    for (int iCand = next++; iCand < int(cands.size()); iCand = next++)
+	      results.at(iCand) = Evaluate( cands.at(iCand), prune_loss );
+	  } ) );
+    }
+    for (UInt_t iTh = 0; iTh < threads.size(); iTh++)
+      threads.at(iTh).join();
+
+    // New beam: best of the old beam and the finished candidates
+    int nPruned = 0;
+    const double best_loss = beam.front().loss;
+    std::vector<Result> pool = beam;
+    for (UInt_t iCand = 0; iCand < results.size(); iCand++) {
+      done[ results.at(iCand).mask ] = results.at(iCand);
+      if (results.at(iCand).pruned) nPruned += 1;
+      else pool.push_back( results.at(iCand) );
+    }
+    std::sort( pool.begin(), pool.end(), VarSearchRank );
+    pool.resize( std::min( int(pool.size()), beam_width ) );
+
+    bool changed = false;
+    for (UInt_t iB = 0; iB < pool.size(); iB++)
+      if ( iB >= beam.size() || pool.at(iB).mask != beam.at(iB).mask ) changed = true;
+    beam = pool;
+
+    char line[256];
+    snprintf( line, sizeof(line), "Step %d: %d masks trained, %d pruned, best 0x%08x (%d variables) with loss %.6g",
+	      iStep + 1, int(cands.size()), nPruned, beam.front().mask, beam.front().n_vars, beam.front().loss );
+    std::cout << line << std::endl;
+    if ( !changed || beam.front().loss > best_loss * (1 - MIN_GAIN) ) break;
+  } // End loop: for (int iStep = 0; iStep < max_steps; iStep++)
+
+  std::vector<Result> ranked;
+  for (std::map<UInt_t, Result>::const_iterator it = done.begin(); it != done.end(); it++)
+    ranked.push_back( it->second );
+  std::sort( ranked.begin(), ranked.end(), VarSearchRank );
+  return ranked;
+
+} // End function: std::vector<VarSearch::Result> VarSearch::Search()
+
+
+void VarSearch::Print( const std::vector<Result>& results, const UInt_t start_mask ) const {
+
+  double start_loss = -1;
+  for (UInt_t i = 0; i < results.size(); i++)
+    if (results.at(i).mask == start_mask) start_loss = results.at(i).loss;
+
+  std::cout << "\n" << std::string(100, '*') << "\n" << name << ": " << results.size() << " masks ranked by validation loss "
+	    << "(start mask 0x" << std::hex << start_mask << std::dec << ")\n" << std::string(100, '*') << std::endl;
+  std::cout << "Rank  Mask        nVar  Loss          / start  Trees  Seconds  Change" << std::endl;
+  for (UInt_t i = 0; i < results.size(); i++) {
+    const Result& res = results.at(i);
+    TString change = "";
+    for (UInt_t iVar = 0; iVar < bits.size(); iVar++) {
+      const UInt_t bit = (0x1u << bits.at(iVar));
+      if ( (res.mask & bit) && !(start_mask & bit) ) change += " +"+var_names.at(iVar);
+      if ( !(res.mask & bit) && (start_mask & bit) ) change += " -"+var_names.at(iVar);
+    }
+    char line[256];
+    snprintf( line, sizeof(line), "%4d  0x%08x  %4d  %-12.6g  %7.4f  %5d  %7.2f ",
+	      i + 1, res.mask, res.n_vars, (res.pruned ? res.loss_prune : res.loss),
+	      (start_loss > 0 ? (res.pruned ? res.loss_prune : res.loss) / start_loss : 0), res.n_trees, res.seconds );
+    std::cout << line << (res.pruned ? " (pruned)" : "") << change << std::endl;
+  }
+
+} // End function: void VarSearch::Print()